@@ -25,8 +25,15 @@
 
 #include "alg/error.h"
 #include "alg/fun.h"
+#include "alg/alloc.h"
 #include "alg/vector.h"
 #include "alg/list.h"
+#include "alg/deque.h"
+#include "alg/hashmap.h"
+#include "alg/ulist.h"
+#include "alg/queue.h"
+#include "alg/cvector.h"
+#include "alg/iter.h"
 
 #endif
 
@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "alloc.h"
+#include "error.h"
+#include "help.h"
+#include <string.h>
+
+// every allocation is preceded by its size, so realloc knows how much to copy
+#define ALG_ARENA_HEAD ((sizeof(size_t)+ALG_ARENA_ALIGN-1) & ~(ALG_ARENA_ALIGN-1))
+
+struct alg_arena_block
+{
+    struct alg_arena_block *next;
+    size_t size, used;
+    char mem[] __attribute__((aligned(ALG_ARENA_ALIGN)));
+};
+
+size_t alg_arena_intern_align(size_t size)
+{
+    return (size+ALG_ARENA_ALIGN-1) & ~(size_t)(ALG_ARENA_ALIGN-1);
+}
+
+struct alg_arena_block* alg_arena_intern_block(size_t size, struct alg_arena *arena)
+{
+    struct alg_arena_block *block;
+    
+    if(size < arena->blocksize)
+        size = arena->blocksize;
+    
+    block = malloc(sizeof(struct alg_arena_block)+size);
+    if(!block)
+        RETZ(ALG_ERROR_NO_MEMORY, arena);
+    
+    block->size = size;
+    block->used = 0;
+    block->next = arena->block;
+    arena->block = block;
+    
+    RET(block, arena);
+}
+
+void* alg_arena_intern_alloc(size_t size, void *ctx)
+{
+    return alg_arena_alloc(size, ctx);
+}
+
+void* alg_arena_intern_realloc(void *ptr, size_t size, void *ctx)
+{
+    return alg_arena_realloc(ptr, size, ctx);
+}
+
+void alg_arena_intern_free(void *ptr, void *ctx)
+{
+    // memory is released as a whole by alg_arena_reset or alg_arena_finish
+}
+
+int alg_arena_init(size_t blocksize, struct alg_arena **parena)
+{
+    int malloced = 0;
+    struct alg_arena *arena;
+    
+    if(!parena)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*parena)
+    {
+        malloced = 1;
+        *parena = malloc(sizeof(struct alg_arena));
+        if(!*parena)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    arena = *parena;
+    arena->block = 0;
+    arena->last = 0;
+    arena->blocksize = blocksize ? alg_arena_intern_align(blocksize) : ALG_ARENA_BLOCK;
+    arena->status = ALG_STATUS_MALLOCED*malloced;
+    arena->allocator.alloc = alg_arena_intern_alloc;
+    arena->allocator.realloc = alg_arena_intern_realloc;
+    arena->allocator.free = alg_arena_intern_free;
+    arena->allocator.ctx = arena;
+    
+    RET(ALG_SUCCESS, arena);
+}
+
+int alg_arena_finish(struct alg_arena *arena)
+{
+    struct alg_arena_block *block, *next;
+    
+    if(!arena)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    for(block=arena->block; block; block=next)
+    {
+        next = block->next;
+        free(block);
+    }
+    
+    if(arena->status & ALG_STATUS_MALLOCED)
+        free(arena);
+    else
+        memset(arena, 0, sizeof(struct alg_arena));
+    
+    return ALG_SUCCESS;
+}
+
+struct alg_allocator* alg_arena_allocator(struct alg_arena *arena)
+{
+    if(!arena)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, arena);
+    
+    RET(&arena->allocator, arena);
+}
+
+void* alg_arena_alloc(size_t size, struct alg_arena *arena)
+{
+    struct alg_arena_block *block;
+    void *ptr;
+    
+    if(!arena)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, arena);
+    
+    size = ALG_ARENA_HEAD+alg_arena_intern_align(size);
+    block = arena->block;
+    
+    if(!block || block->size-block->used < size)
+    {
+        block = alg_arena_intern_block(size, arena);
+        CATCHZ(arena);
+    }
+    
+    ptr = block->mem+block->used;
+    block->used += size;
+    *(size_t*)ptr = size-ALG_ARENA_HEAD;
+    arena->last = ptr+ALG_ARENA_HEAD;
+    
+    RET(arena->last, arena);
+}
+
+void* alg_arena_realloc(void *ptr, size_t size, struct alg_arena *arena)
+{
+    struct alg_arena_block *block;
+    size_t old;
+    void *tmp;
+    
+    if(!arena)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, arena);
+    
+    if(!ptr)
+        return alg_arena_alloc(size, arena);
+    
+    old = *(size_t*)(ptr-ALG_ARENA_HEAD);
+    size = alg_arena_intern_align(size);
+    block = arena->block;
+    
+    // the most recent allocation can be resized in place
+    if(ptr == arena->last && block->size-block->used+old >= size)
+    {
+        block->used = block->used-old+size;
+        *(size_t*)(ptr-ALG_ARENA_HEAD) = size;
+        RET(ptr, arena);
+    }
+    
+    if(size <= old)
+        RET(ptr, arena);
+    
+    tmp = alg_arena_alloc(size, arena);
+    CATCHZ(arena);
+    memcpy(tmp, ptr, old);
+    
+    RET(tmp, arena);
+}
+
+void alg_arena_reset(struct alg_arena *arena)
+{
+    struct alg_arena_block *block, *next;
+    
+    if(!arena)
+        RETV(ALG_ERROR_BAD_STRUCTURE, arena);
+    
+    if(!arena->block)
+        RETV(ALG_SUCCESS, arena);
+    
+    // keep the newest block for reuse
+    for(block=arena->block->next; block; block=next)
+    {
+        next = block->next;
+        free(block);
+    }
+    
+    arena->block->next = 0;
+    arena->block->used = 0;
+    arena->last = 0;
+    
+    arena->error = ALG_SUCCESS;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+
+int catch(struct alg_arena *arena)
+{
+    if(arena->error != ALG_SUCCESS)
+    {
+        printf("error: %s\n", alg_str_error(arena->error));
+        return 1;
+    }
+    return 0;
+}
+
+void show_arena(struct alg_arena *arena)
+{
+    int count = 0;
+    size_t used = 0;
+    struct alg_arena_block *block;
+    
+    for(block=arena->block; block; block=block->next)
+    {
+        count++;
+        used += block->used;
+    }
+    printf("blocks: %i | used: %zu\n", count, used);
+}
+
+int main(int argc, char *argv[])
+{
+    struct alg_arena *arena = 0;
+    struct alg_allocator *alloc;
+    int i, *a, *b;
+    
+    if(alg_arena_init(256, &arena) != ALG_SUCCESS)
+        return 1;
+    show_arena(arena);
+    
+    alloc = alg_arena_allocator(arena);
+    if(catch(arena))
+        return 1;
+    
+    a = alg_alloc(10*sizeof(int), alloc);
+    if(catch(arena))
+        return 1;
+    for(i=0; i<10; i++)
+        a[i] = i;
+    show_arena(arena);
+    
+    b = alg_realloc(a, 20*sizeof(int), alloc);
+    if(catch(arena))
+        return 1;
+    printf("in place: %s\n", a == b ? "yes" : "no");
+    show_arena(arena);
+    
+    alg_alloc(8, alloc);
+    a = alg_realloc(b, 40*sizeof(int), alloc);
+    if(catch(arena))
+        return 1;
+    printf("in place: %s | a[9]: %i\n", a == b ? "yes" : "no", a[9]);
+    show_arena(arena);
+    
+    alg_alloc(1000, alloc);
+    if(catch(arena))
+        return 1;
+    show_arena(arena);
+    
+    alg_arena_reset(arena);
+    if(catch(arena))
+        return 1;
+    show_arena(arena);
+    
+    if(alg_arena_finish(arena) != ALG_SUCCESS)
+        return 1;
+    
+    return 0;
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_ALLOC_H__
+#define __ALG_ALLOC_H__
+
+#include <stdlib.h>
+
+#define ALG_ARENA_BLOCK 65536
+#define ALG_ARENA_ALIGN 16
+
+struct alg_allocator
+{
+    void* (*alloc)(size_t size, void *ctx);
+    void* (*realloc)(void *ptr, size_t size, void *ctx);
+    void  (*free)(void *ptr, void *ctx);
+    void *ctx;
+};
+
+struct alg_arena_block;
+
+struct alg_arena
+{
+    struct alg_arena_block *block;
+    struct alg_allocator allocator;
+    void *last;
+    size_t blocksize;
+    int error;
+    char status;
+};
+
+// a null allocator selects libc
+
+static inline void* alg_alloc(size_t size, struct alg_allocator *alloc)
+{
+    return alloc ? alloc->alloc(size, alloc->ctx) : malloc(size);
+}
+
+static inline void* alg_realloc(void *ptr, size_t size, struct alg_allocator *alloc)
+{
+    return alloc ? alloc->realloc(ptr, size, alloc->ctx) : realloc(ptr, size);
+}
+
+static inline void alg_free(void *ptr, struct alg_allocator *alloc)
+{
+    if(alloc)
+        alloc->free(ptr, alloc->ctx);
+    else
+        free(ptr);
+}
+
+int alg_arena_init(size_t blocksize, struct alg_arena **arena);
+int alg_arena_finish(struct alg_arena *arena);
+
+struct alg_allocator* alg_arena_allocator(struct alg_arena *arena);
+
+void* alg_arena_alloc(size_t size, struct alg_arena *arena);
+void* alg_arena_realloc(void *ptr, size_t size, struct alg_arena *arena);
+void  alg_arena_reset(struct alg_arena *arena);
+
+#endif
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "cvector.h"
+#include "error.h"
+#include "help.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+// segment k starts at ALG_CVECTOR_SEGMENT*(2^k-1)
+int cvector_intern_segment(int pos)
+{
+    return 31-__builtin_clz(pos/ALG_CVECTOR_SEGMENT+1);
+}
+
+int cvector_intern_start(int segment)
+{
+    return ALG_CVECTOR_SEGMENT*((1 << segment)-1);
+}
+
+// makes sure the segments of a claimed range exist, racing allocations
+// are settled by a CAS and the loser frees its copy
+int cvector_intern_ensure(int from, int to, struct cvector *vec)
+{
+    int k, last = cvector_intern_segment(to);
+    char *seg, *expected;
+    
+    if(last >= ALG_CVECTOR_SEGMENTS)
+        return ALG_ERROR_NO_MEMORY;
+    
+    for(k=cvector_intern_segment(from); k<=last; k++)
+    {
+        if(atomic_load_explicit(&vec->segments[k], memory_order_acquire))
+            continue;
+        
+        seg = malloc((size_t)(ALG_CVECTOR_SEGMENT << k)*vec->esize);
+        if(!seg)
+            return ALG_ERROR_NO_MEMORY;
+        
+        expected = 0;
+        if(!atomic_compare_exchange_strong_explicit(&vec->segments[k], &expected, seg,
+            memory_order_acq_rel, memory_order_acquire))
+            free(seg);
+    }
+    
+    return ALG_SUCCESS;
+}
+
+int cvector_init(int elemsize, struct cvector **pvec)
+{
+    int i, malloced = 0;
+    struct cvector *vec;
+    
+    if(elemsize <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pvec)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pvec)
+    {
+        malloced = 1;
+        *pvec = aligned_alloc(ALG_CACHE_LINE, sizeof(struct cvector));
+        if(!*pvec)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    vec = *pvec;
+    vec->esize = elemsize;
+    vec->status = ALG_STATUS_MALLOCED*malloced;
+    vec->error = ALG_SUCCESS;
+    atomic_init(&vec->size, 0);
+    for(i=0; i<ALG_CVECTOR_SEGMENTS; i++)
+        atomic_init(&vec->segments[i], 0);
+    
+    return ALG_SUCCESS;
+}
+
+int cvector_finish(struct cvector *vec)
+{
+    int i;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    for(i=0; i<ALG_CVECTOR_SEGMENTS; i++)
+        free(atomic_load(&vec->segments[i]));
+    
+    if(vec->status & ALG_STATUS_MALLOCED)
+        free(vec);
+    else
+        memset(vec, 0, sizeof(struct cvector));
+    
+    return ALG_SUCCESS;
+}
+
+void* cvector_push(void *elem, struct cvector *vec)
+{
+    void *ptr;
+    int pos;
+    
+    if(!vec || !elem)
+        return 0;
+    
+    if((pos = cvector_reserve_block(1, vec)) < 0)
+        return 0;
+    
+    ptr = cvector_at(pos, vec);
+    memcpy(ptr, elem, vec->esize);
+    
+    return ptr;
+}
+
+// claims count consecutive slots and returns the first index, the range
+// may cross segments, cvector_span gives the contiguous pieces
+int cvector_reserve_block(int count, struct cvector *vec)
+{
+    int pos, ret;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(count <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    // the segments are in place before the size covers them, so a failed
+    // reserve leaves the size untouched and no slot without memory
+    pos = atomic_load_explicit(&vec->size, memory_order_relaxed);
+    do
+    {
+        if(pos > INT_MAX-count)
+            return ALG_ERROR_NO_MEMORY;
+        if((ret = cvector_intern_ensure(pos, pos+count-1, vec)) != ALG_SUCCESS)
+            return ret;
+    }
+    while(!atomic_compare_exchange_weak_explicit(&vec->size, &pos, pos+count,
+        memory_order_relaxed, memory_order_relaxed));
+    
+    return pos;
+}
+
+void* cvector_at(int pos, struct cvector *vec)
+{
+    int k;
+    char *seg;
+    
+    if(!vec || pos < 0 || pos >= atomic_load_explicit(&vec->size, memory_order_relaxed))
+        return 0;
+    
+    k = cvector_intern_segment(pos);
+    if(!(seg = atomic_load_explicit(&vec->segments[k], memory_order_acquire)))
+        return 0;
+    
+    return seg+(long)(pos-cvector_intern_start(k))*vec->esize;
+}
+
+// cuts *count down to the slots from pos on lying in the same segment
+void* cvector_span(int pos, int *count, struct cvector *vec)
+{
+    int end;
+    void *ptr;
+    
+    if(!count || !(ptr = cvector_at(pos, vec)))
+        return 0;
+    
+    end = cvector_intern_start(cvector_intern_segment(pos)+1);
+    if(*count > end-pos)
+        *count = end-pos;
+    
+    return ptr;
+}
+
+int cvector_size(struct cvector *vec)
+{
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    return atomic_load_explicit(&vec->size, memory_order_relaxed);
+}
+
+// not safe against concurrent appends
+int cvector_fold(alg_foldfun fun, void *state, struct cvector *vec)
+{
+    int i, k, end, size, ret;
+    char *seg;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    size = atomic_load(&vec->size);
+    
+    for(i=0, k=0; i<size; k++)
+    {
+        seg = atomic_load_explicit(&vec->segments[k], memory_order_acquire);
+        if(!seg)
+            return ALG_ERROR_BAD_STRUCTURE;
+        end = cvector_intern_start(k+1);
+        for(; i<size && i<end; i++, seg+=vec->esize)
+            if((ret = fun(i, seg, state)) != ALG_SUCCESS)
+                return ret;
+    }
+    
+    return ALG_SUCCESS;
+}
+
+// not safe against concurrent appends, the segments are kept
+int cvector_clear(struct cvector *vec)
+{
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    atomic_store(&vec->size, 0);
+    
+    return ALG_SUCCESS;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+
+#define TEST_THREADS    4
+#define TEST_ITEMS      100000
+
+struct test_state
+{
+    struct cvector *vec;
+    int id;
+};
+
+void* test_append(void *arg)
+{
+    struct test_state *s = arg;
+    int i, j, n, pos, count, *ptr;
+    
+    for(i=0; i<TEST_ITEMS;)
+    {
+        // every tenth round claims a block and fills it piecewise
+        if(i%10 == 0 && i+32 <= TEST_ITEMS)
+        {
+            if((pos = cvector_reserve_block(32, s->vec)) < 0)
+                return s;
+            for(n=0; n<32; n+=count)
+            {
+                count = 32-n;
+                ptr = cvector_span(pos+n, &count, s->vec);
+                for(j=0; j<count; j++)
+                    ptr[j] = s->id*TEST_ITEMS+i+n+j;
+            }
+            i += 32;
+            continue;
+        }
+        j = s->id*TEST_ITEMS+i;
+        if(!cvector_push(&j, s->vec))
+            return s;
+        i++;
+    }
+    
+    return 0;
+}
+
+int test_seen(int pos, void *elem, void *state)
+{
+    char *seen = state;
+    int value = *(int*)elem;
+    
+    if(value < 0 || value >= TEST_THREADS*TEST_ITEMS || seen[value])
+        return ALG_ERROR_BAD_STRUCTURE;
+    seen[value] = 1;
+    
+    return ALG_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    struct cvector *vec = 0;
+    struct test_state s[TEST_THREADS];
+    pthread_t t[TEST_THREADS];
+    int i, *first, failed = 0;
+    char *seen;
+    
+    if(cvector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    i = 42;
+    first = cvector_push(&i, vec);
+    for(i=0; i<1000; i++)
+        cvector_push(&i, vec);
+    printf("size: %i | first: %i | at 500: %i | same pointer: %s\n", cvector_size(vec),
+        *first, *(int*)cvector_at(500, vec), first == cvector_at(0, vec) ? "yes" : "no");
+    printf("out of range: %s\n", cvector_at(1001, vec) ? "found" : "null");
+    
+    // a reserve that cannot be met leaves the size alone
+    i = cvector_reserve_block(1 << 30, vec);
+    printf("huge reserve: %s | size %i", alg_str_error(i), cvector_size(vec));
+    printf(" | push: %s\n", cvector_push(&i, vec) ? "ok" : "failed");
+    
+    cvector_clear(vec);
+    
+    for(i=0; i<TEST_THREADS; i++)
+    {
+        s[i].vec = vec;
+        s[i].id = i;
+        pthread_create(&t[i], 0, test_append, &s[i]);
+    }
+    for(i=0; i<TEST_THREADS; i++)
+    {
+        void *ret;
+        pthread_join(t[i], &ret);
+        failed |= ret != 0;
+    }
+    
+    seen = calloc(TEST_THREADS*TEST_ITEMS, 1);
+    if(failed || !seen || cvector_fold(test_seen, seen, vec) != ALG_SUCCESS)
+        return 1;
+    printf("threaded: size %i | all distinct\n", cvector_size(vec));
+    free(seen);
+    
+    return cvector_finish(vec) != ALG_SUCCESS;
+}
+
+#endif
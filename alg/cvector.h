@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_CVECTOR_H__
+#define __ALG_CVECTOR_H__
+
+#include "fun.h"
+#include "thread.h"
+#include <stdatomic.h>
+
+#define ALG_CVECTOR_SEGMENT     64  // elements in the first segment, every further one doubles
+#define ALG_CVECTOR_SEGMENTS    24
+
+// Append-only vector for any number of concurrent writers. Slots are
+// claimed with a fetch-add on size and live in segments that never move,
+// so element pointers stay valid until cvector_finish. A claimed slot holds
+// data once the claiming call returned and its writer has synchronized
+// with the reader. Results are returned only, the error field is never
+// written since it would be shared between threads.
+
+struct cvector
+{
+    _Atomic int size __attribute__((aligned(ALG_CACHE_LINE)));
+    _Atomic(char*) segments[ALG_CVECTOR_SEGMENTS] __attribute__((aligned(ALG_CACHE_LINE)));
+    int esize, error;
+    char status;
+};
+
+int cvector_init(int elemsize, struct cvector **vec);
+int cvector_finish(struct cvector *vec);
+
+void* cvector_push(void *elem, struct cvector *vec);
+int   cvector_reserve_block(int count, struct cvector *vec);
+
+void* cvector_at(int pos, struct cvector *vec);
+void* cvector_span(int pos, int *count, struct cvector *vec);
+int   cvector_size(struct cvector *vec);
+
+int cvector_fold(alg_foldfun fun, void *state, struct cvector *vec);
+int cvector_clear(struct cvector *vec);
+
+#endif
@@ -0,0 +1,433 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "deque.h"
+#include "error.h"
+#include "help.h"
+#include <string.h>
+#include <limits.h>
+
+#define SLOT(d, pos)    ((d)->mem+(((d)->head+(pos)) & ((d)->capacity-1))*(d)->esize)
+
+// the largest power of two capacity whose byte size still fits an int
+int deque_intern_max(struct deque *d)
+{
+    int max;
+    
+    for(max=d->capacity; max <= INT_MAX/d->esize/2; max*=2);
+    
+    return max;
+}
+
+// grows to the next power of two holding capacity, the wrapped part of the
+// ring is the only data that has to move and the smaller side is chosen
+void deque_intern_grow(int capacity, struct deque *d)
+{
+    int size, front, back;
+    void *mem;
+    
+    if(capacity > deque_intern_max(d))
+        RETV(ALG_ERROR_NO_MEMORY, d);
+    
+    for(size=d->capacity; size<capacity; size*=2);
+    if(size == d->capacity)
+        RETV(ALG_SUCCESS, d);
+    
+    mem = alg_realloc(d->mem, (size_t)size*d->esize, d->alloc);
+    if(!mem)
+        RETV(ALG_ERROR_NO_MEMORY, d);
+    d->mem = mem;
+    
+    if(d->head+d->size > d->capacity)
+    {
+        front = d->capacity-d->head;
+        back = d->size-front;
+        if(back <= front)
+            memcpy(mem+d->capacity*d->esize, mem, back*d->esize);
+        else
+        {
+            memcpy(mem+(size-front)*d->esize, mem+d->head*d->esize, front*d->esize);
+            d->head = size-front;
+        }
+    }
+    
+    d->capacity = size;
+    d->error = ALG_SUCCESS;
+}
+
+void* deque_intern_set(void *ptr, void *elem, struct deque *d)
+{
+    if(elem)
+        memcpy(ptr, elem, d->esize);
+    else
+        memset(ptr, 0, d->esize);
+    
+    RET(ptr, d);
+}
+
+int deque_init(int elemsize, struct deque **d)
+{
+    return deque_init_alloc(elemsize, 0, d);
+}
+
+int deque_init_alloc(int elemsize, struct alg_allocator *alloc, struct deque **pd)
+{
+    int malloced = 0;
+    struct deque *d;
+    
+    if(elemsize <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pd)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pd)
+    {
+        malloced = 1;
+        *pd = alg_alloc(sizeof(struct deque), alloc);
+        if(!*pd)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    d = *pd;
+    d->mem = alg_alloc(ALG_DEQUE_CAPACITY*elemsize, alloc);
+    
+    if(!d->mem)
+    {
+        if(malloced)
+            alg_free(d, alloc);
+        return ALG_ERROR_NO_MEMORY;
+    }
+    
+    d->esize = elemsize;
+    d->capacity = ALG_DEQUE_CAPACITY;
+    d->head = 0;
+    d->size = 0;
+    d->alloc = alloc;
+    d->status = ALG_STATUS_MALLOCED*malloced;
+    
+    RET(ALG_SUCCESS, d);
+}
+
+int deque_finish(struct deque *d)
+{
+    return deque_finish_custom(0, 0, d);
+}
+
+int deque_finish_custom(alg_foldfun fun, void *state, struct deque *d)
+{
+    deque_clear_custom(fun, state, d);
+    CATCHE(d);
+    
+    alg_free(d->mem, d->alloc);
+    
+    if(d->status & ALG_STATUS_MALLOCED)
+        alg_free(d, d->alloc);
+    else
+        memset(d, 0, sizeof(struct deque));
+    
+    return ALG_SUCCESS;
+}
+
+void* deque_at(int pos, struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(pos < 0 || pos >= d->size)
+        RETZ(ALG_ERROR_INDEX_RANGE, d);
+    
+    RET(SLOT(d, pos), d);
+}
+
+void* deque_get(int pos, void *dst, struct deque *d)
+{
+    void *ptr;
+    
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(!dst)
+        RETZ(ALG_ERROR_BAD_DESTINATION, d);
+    
+    ptr = deque_at(pos, d);
+    CATCHZ(d);
+    
+    memcpy(dst, ptr, d->esize);
+    
+    RET(ptr, d);
+}
+
+void* deque_first(struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(!d->size)
+        RETZ(ALG_ERROR_EMPTY, d);
+    
+    RET(SLOT(d, 0), d);
+}
+
+void* deque_last(struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(!d->size)
+        RETZ(ALG_ERROR_EMPTY, d);
+    
+    RET(SLOT(d, d->size-1), d);
+}
+
+int deque_size(struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    RET(d->size, d);
+}
+
+void* deque_push_front(void *elem, struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(d->size == d->capacity)
+    {
+        deque_intern_grow(d->size+1, d);
+        CATCHZ(d);
+    }
+    
+    d->head = (d->head-1) & (d->capacity-1);
+    d->size++;
+    
+    return deque_intern_set(SLOT(d, 0), elem, d);
+}
+
+void* deque_push_back(void *elem, struct deque *d)
+{
+    if(!d)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(d->size == d->capacity)
+    {
+        deque_intern_grow(d->size+1, d);
+        CATCHZ(d);
+    }
+    
+    d->size++;
+    
+    return deque_intern_set(SLOT(d, d->size-1), elem, d);
+}
+
+void deque_pop_front(void *dst, struct deque *d)
+{
+    deque_pop_front_custom(dst, 0, d);
+}
+
+void deque_pop_front_custom(void *dst, alg_mapfun fun, struct deque *d)
+{
+    void *ptr;
+    
+    if(!d)
+        RETV(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(!d->size)
+        RETV(ALG_ERROR_EMPTY, d);
+    
+    ptr = SLOT(d, 0);
+    
+    if(dst)
+        memcpy(dst, ptr, d->esize);
+    
+    if(fun)
+        fun(ptr);
+    
+    d->head = (d->head+1) & (d->capacity-1);
+    d->size--;
+    d->error = ALG_SUCCESS;
+}
+
+void deque_pop_back(void *dst, struct deque *d)
+{
+    deque_pop_back_custom(dst, 0, d);
+}
+
+void deque_pop_back_custom(void *dst, alg_mapfun fun, struct deque *d)
+{
+    void *ptr;
+    
+    if(!d)
+        RETV(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(!d->size)
+        RETV(ALG_ERROR_EMPTY, d);
+    
+    ptr = SLOT(d, d->size-1);
+    
+    if(dst)
+        memcpy(dst, ptr, d->esize);
+    
+    if(fun)
+        fun(ptr);
+    
+    d->size--;
+    d->error = ALG_SUCCESS;
+}
+
+void deque_reserve(int capacity, struct deque *d)
+{
+    if(!d)
+        RETV(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(capacity < 0 || capacity > deque_intern_max(d))
+        RETV(ALG_ERROR_BAD_SIZE, d);
+    
+    deque_intern_grow(capacity, d);
+}
+
+void deque_fold(alg_foldfun fun, void *state, struct deque *d)
+{
+    int i, ret;
+    
+    if(!d)
+        RETV(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    for(i=0; i<d->size; i++)
+        if((ret = fun(i, SLOT(d, i), state)) != ALG_SUCCESS)
+            RETV(ret, d);
+    
+    d->error = ALG_SUCCESS;
+}
+
+void deque_clear(struct deque *d)
+{
+    deque_clear_custom(0, 0, d);
+}
+
+void deque_clear_custom(alg_foldfun fun, void *state, struct deque *d)
+{
+    int i;
+    
+    if(!d)
+        RETV(ALG_ERROR_BAD_STRUCTURE, d);
+    
+    if(fun)
+        for(i=0; i<d->size; i++)
+            fun(i, SLOT(d, i), state);
+    
+    d->head = 0;
+    d->size = 0;
+    d->error = ALG_SUCCESS;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+
+void show_deque(struct deque *d)
+{
+    int i;
+    
+    printf("size: %i | capacity: %i | head: %i | elems:", d->size, d->capacity, d->head);
+    if(!d->size)
+        printf(" empty");
+    for(i=0; i<d->size; i++)
+        printf(" %i", *(int*)SLOT(d, i));
+    printf("\n");
+}
+
+int catch(struct deque *d)
+{
+    if(d->error != ALG_SUCCESS)
+    {
+        printf("error: %s\n", alg_str_error(d->error));
+        return 1;
+    }
+    return 0;
+}
+
+int test_sum(int pos, void *elem, void *state)
+{
+    *(int*)state += *(int*)elem;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct deque *d = 0;
+    int i, j, sum = 0;
+    
+    if(deque_init(sizeof(int), &d) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<5; i++)
+        deque_push_back(&i, d);
+    for(i=10; i<13; i++)
+        deque_push_front(&i, d);
+    show_deque(d);
+    
+    printf("grow while wrapped:\n");
+    i = 13;
+    deque_push_front(&i, d);
+    show_deque(d);
+    
+    deque_pop_front(&j, d);
+    printf("pop front: %i\n", j);
+    deque_pop_back(&j, d);
+    printf("pop back: %i\n", j);
+    
+    printf("at 2: %i\n", *(int*)deque_at(2, d));
+    deque_at(7, d);
+    catch(d);
+    
+    deque_fold(test_sum, &sum, d);
+    printf("sum: %i\n", sum);
+    
+    // fifo traffic keeps the ring at its size
+    for(i=0; i<1000; i++)
+    {
+        deque_push_back(&i, d);
+        deque_pop_front(0, d);
+    }
+    show_deque(d);
+    
+    deque_reserve(100, d);
+    show_deque(d);
+    
+    // capacities beyond the largest int sized ring are refused up front
+    deque_reserve(INT_MAX, d);
+    if(d->error != ALG_ERROR_BAD_SIZE)
+        return 1;
+    deque_reserve(1<<29, d);
+    if(d->error != ALG_ERROR_BAD_SIZE)
+        return 1;
+    
+    deque_clear(d);
+    deque_pop_back(0, d);
+    catch(d);
+    
+    return deque_finish(d) != ALG_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_DEQUE_H__
+#define __ALG_DEQUE_H__
+
+#include "fun.h"
+#include "alloc.h"
+
+#define ALG_DEQUE_CAPACITY  8   // initial capacity, power of two
+
+struct deque
+{
+    void *mem;
+    struct alg_allocator *alloc;
+    int head, size, esize, capacity, error;
+    char status;
+};
+
+int deque_init(int elemsize, struct deque **d);
+int deque_init_alloc(int elemsize, struct alg_allocator *alloc, struct deque **d);
+int deque_finish(struct deque *d);
+int deque_finish_custom(alg_foldfun fun, void *state, struct deque *d);
+
+void* deque_at(int pos, struct deque *d);
+void* deque_get(int pos, void *dst, struct deque *d);
+void* deque_first(struct deque *d);
+void* deque_last(struct deque *d);
+int   deque_size(struct deque *d);
+
+void* deque_push_front(void *elem, struct deque *d);
+void* deque_push_back(void *elem, struct deque *d);
+
+void deque_pop_front(void *dst, struct deque *d);
+void deque_pop_front_custom(void *dst, alg_mapfun fun, struct deque *d);
+void deque_pop_back(void *dst, struct deque *d);
+void deque_pop_back_custom(void *dst, alg_mapfun fun, struct deque *d);
+
+void deque_reserve(int capacity, struct deque *d);
+void deque_fold(alg_foldfun fun, void *state, struct deque *d);
+
+void deque_clear(struct deque *d);
+void deque_clear_custom(alg_foldfun fun, void *state, struct deque *d);
+
+#endif
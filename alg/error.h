@@ -33,13 +33,14 @@
 #define ALG_ERROR_EMPTY             -7
 #define ALG_ERROR_NOT_FOUND         -8
 #define ALG_ERROR_UNSET             -9
+#define ALG_ERROR_FULL              -10
 
 #define alg_error(obj) \
 { \
     return (obj)->error; \
 }
 
-char* alg_str_error(int error)
+static inline char* alg_str_error(int error)
 {
     switch(error)
     {
@@ -53,6 +54,7 @@ char* alg_str_error(int error)
         case ALG_ERROR_EMPTY:           return "empty";
         case ALG_ERROR_NOT_FOUND:       return "not found";
         case ALG_ERROR_UNSET:           return "property unset";
+        case ALG_ERROR_FULL:            return "full";
     }
     return "unknown error";
 }
@@ -25,6 +25,9 @@
 
 typedef int alg_foldfun(int pos, void *elem, void *state);
 typedef int alg_mapfun(void *elem);
+typedef int alg_reducefun(void *state, void *other);
+typedef int alg_cmpfun(void *a, void *b);
+typedef unsigned long long alg_hashfun(void *key, int size);
 
 #endif
 
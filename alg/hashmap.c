@@ -0,0 +1,676 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "hashmap.h"
+#include "error.h"
+#include "help.h"
+#include <string.h>
+#include <limits.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define CTRL_EMPTY      0x80
+#define CTRL_DELETED    0xfe
+#define CTRL_FULL(c)    (!((c) & 0x80))
+
+#define LOAD_MAX(cap)   ((cap)/8*7)
+#define SLOT(t, idx, m) ((t)->slots+(long)(idx)*(m)->stride)
+
+// a group is scanned with one compare, every function returns a bitmask
+// with bit i set for control byte i
+
+#ifdef __SSE2__
+
+unsigned hashmap_intern_match(unsigned char *ctrl, unsigned char byte)
+{
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((__m128i*)ctrl), _mm_set1_epi8(byte)));
+}
+
+unsigned hashmap_intern_empty(unsigned char *ctrl)
+{
+    return hashmap_intern_match(ctrl, CTRL_EMPTY);
+}
+
+unsigned hashmap_intern_free(unsigned char *ctrl)
+{
+    return _mm_movemask_epi8(_mm_loadu_si128((__m128i*)ctrl));
+}
+
+#else
+
+#define LSB 0x0101010101010101ULL
+#define MSB 0x8080808080808080ULL
+
+// gathers the top bit of every byte into the low 8 bits
+unsigned hashmap_intern_pack(unsigned long long w)
+{
+    return ((w >> 7)*0x0102040810204080ULL) >> 56;
+}
+
+// may report a byte above a real match, callers compare the keys anyway
+unsigned hashmap_intern_match(unsigned char *ctrl, unsigned char byte)
+{
+    unsigned long long w[2];
+    int i;
+    unsigned ret = 0;
+    
+    memcpy(w, ctrl, sizeof(w));
+    for(i=0; i<2; i++)
+    {
+        w[i] ^= byte*LSB;
+        ret |= hashmap_intern_pack((w[i]-LSB) & ~w[i] & MSB) << i*8;
+    }
+    
+    return ret;
+}
+
+unsigned hashmap_intern_empty(unsigned char *ctrl)
+{
+    unsigned long long w[2];
+    
+    memcpy(w, ctrl, sizeof(w));
+    return hashmap_intern_pack(w[0] & ~(w[0] << 6) & MSB)
+        | hashmap_intern_pack(w[1] & ~(w[1] << 6) & MSB) << 8;
+}
+
+unsigned hashmap_intern_free(unsigned char *ctrl)
+{
+    unsigned long long w[2];
+    
+    memcpy(w, ctrl, sizeof(w));
+    return hashmap_intern_pack(w[0] & MSB) | hashmap_intern_pack(w[1] & MSB) << 8;
+}
+
+#endif
+
+unsigned long long hashmap_hash(void *key, int size)
+{
+    unsigned char *ptr = key;
+    unsigned long long h = 0x9e3779b97f4a7c15ULL ^ size, w;
+    
+    for(; size > 0; size-=8, ptr+=8)
+    {
+        w = 0;
+        memcpy(&w, ptr, size < 8 ? size : 8);
+        h = (h ^ w)*0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+    
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    
+    return h;
+}
+
+unsigned long long hashmap_intern_hash(void *key, struct hashmap *m)
+{
+    return m->hash ? m->hash(key, m->ksize) : hashmap_hash(key, m->ksize);
+}
+
+int hashmap_intern_equal(void *a, void *b, struct hashmap *m)
+{
+    return m->cmp ? !m->cmp(a, b) : !memcmp(a, b, m->ksize);
+}
+
+void hashmap_intern_table(int capacity, struct hashmap_table *t, struct hashmap *m)
+{
+    t->ctrl = alg_alloc(capacity, m->alloc);
+    t->slots = alg_alloc((long)capacity*m->stride, m->alloc);
+    
+    if(!t->ctrl || !t->slots)
+    {
+        alg_free(t->ctrl, m->alloc);
+        alg_free(t->slots, m->alloc);
+        memset(t, 0, sizeof(struct hashmap_table));
+        RETV(ALG_ERROR_NO_MEMORY, m);
+    }
+    
+    memset(t->ctrl, CTRL_EMPTY, capacity);
+    t->capacity = capacity;
+    t->used = 0;
+    t->tombs = 0;
+    
+    m->error = ALG_SUCCESS;
+}
+
+void hashmap_intern_release(struct hashmap_table *t, struct hashmap *m)
+{
+    alg_free(t->ctrl, m->alloc);
+    alg_free(t->slots, m->alloc);
+    memset(t, 0, sizeof(struct hashmap_table));
+}
+
+// groups are probed triangularly, which visits each of them once
+int hashmap_intern_find(void *key, unsigned long long hash, struct hashmap_table *t, struct hashmap *m)
+{
+    int i, idx, groups = t->capacity/ALG_HASHMAP_GROUP, g = (hash >> 7) & (groups-1);
+    unsigned char *ctrl;
+    unsigned mask;
+    
+    for(i=0; i<groups; i++)
+    {
+        ctrl = t->ctrl+g*ALG_HASHMAP_GROUP;
+        for(mask=hashmap_intern_match(ctrl, hash & 0x7f); mask; mask&=mask-1)
+        {
+            idx = g*ALG_HASHMAP_GROUP+__builtin_ctz(mask);
+            if(hashmap_intern_equal(key, SLOT(t, idx, m), m))
+                return idx;
+        }
+        if(hashmap_intern_empty(ctrl))
+            return -1;
+        g = (g+i+1) & (groups-1);
+    }
+    
+    return -1;
+}
+
+// claims the first free slot on the probe sequence, the load limit
+// guarantees there is one
+int hashmap_intern_claim(unsigned long long hash, struct hashmap_table *t)
+{
+    int i, idx, groups = t->capacity/ALG_HASHMAP_GROUP, g = (hash >> 7) & (groups-1);
+    unsigned mask;
+    
+    for(i=0; !(mask = hashmap_intern_free(t->ctrl+g*ALG_HASHMAP_GROUP)); i++)
+        g = (g+i+1) & (groups-1);
+    
+    idx = g*ALG_HASHMAP_GROUP+__builtin_ctz(mask);
+    if(t->ctrl[idx] == CTRL_DELETED)
+        t->tombs--;
+    t->ctrl[idx] = hash & 0x7f;
+    t->used++;
+    
+    return idx;
+}
+
+// a slot may only become empty again if its group already has an empty
+// slot, otherwise probes that went past it would stop early
+void hashmap_intern_erase(int idx, struct hashmap_table *t)
+{
+    if(hashmap_intern_empty(t->ctrl+idx/ALG_HASHMAP_GROUP*ALG_HASHMAP_GROUP))
+        t->ctrl[idx] = CTRL_EMPTY;
+    else
+    {
+        t->ctrl[idx] = CTRL_DELETED;
+        t->tombs++;
+    }
+    t->used--;
+}
+
+// moves the entries of up to groups groups from the old table, migrated
+// slots are marked deleted there so lookups do not find them twice
+void hashmap_intern_migrate(int groups, struct hashmap *m)
+{
+    int idx, end;
+    void *slot;
+    
+    if(!m->old.capacity)
+        return;
+    
+    end = m->migrated+groups*ALG_HASHMAP_GROUP;
+    if(end > m->old.capacity || groups < 0)
+        end = m->old.capacity;
+    
+    for(; m->migrated<end; m->migrated++)
+    {
+        if(!CTRL_FULL(m->old.ctrl[m->migrated]))
+            continue;
+        slot = SLOT(&m->old, m->migrated, m);
+        idx = hashmap_intern_claim(hashmap_intern_hash(slot, m), &m->table);
+        memcpy(SLOT(&m->table, idx, m), slot, m->stride);
+        m->old.ctrl[m->migrated] = CTRL_DELETED;
+    }
+    
+    if(m->migrated == m->old.capacity)
+        hashmap_intern_release(&m->old, m);
+}
+
+// starts moving everything into a fresh table of the given capacity
+void hashmap_intern_rehash(int capacity, struct hashmap *m)
+{
+    struct hashmap_table table;
+    
+    hashmap_intern_migrate(-1, m);
+    
+    hashmap_intern_table(capacity, &table, m);
+    CATCHV(m);
+    
+    m->old = m->table;
+    m->table = table;
+    m->migrated = 0;
+    
+    if(!m->old.capacity)
+        hashmap_intern_release(&m->old, m);
+}
+
+// makes room for one more entry, a table clogged by tombstones is rebuilt
+// at the same size, otherwise the capacity doubles
+void hashmap_intern_room(struct hashmap *m)
+{
+    struct hashmap_table *t = &m->table;
+    
+    if(t->capacity && t->used+t->tombs < LOAD_MAX(t->capacity))
+        RETV(ALG_SUCCESS, m);
+    
+    if(!t->capacity)
+        hashmap_intern_rehash(ALG_HASHMAP_GROUP, m);
+    else if(m->size < LOAD_MAX(t->capacity)/2)
+        hashmap_intern_rehash(t->capacity, m);
+    else
+        hashmap_intern_rehash(t->capacity*2, m);
+}
+
+int hashmap_init(int keysize, int valsize, struct hashmap **m)
+{
+    return hashmap_init_custom(keysize, valsize, 0, 0, 0, m);
+}
+
+int hashmap_init_custom(int keysize, int valsize, alg_hashfun hash, alg_cmpfun cmp, struct alg_allocator *alloc, struct hashmap **pm)
+{
+    int malloced = 0, kalign, valign;
+    struct hashmap *m;
+    
+    if(keysize <= 0 || valsize < 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pm)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pm)
+    {
+        malloced = 1;
+        *pm = alg_alloc(sizeof(struct hashmap), alloc);
+        if(!*pm)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    m = *pm;
+    memset(m, 0, sizeof(struct hashmap));
+    
+    // keys and values keep the natural alignment of their size up to 8
+    kalign = keysize & -keysize;
+    kalign = kalign > 8 ? 8 : kalign;
+    valign = valsize ? valsize & -valsize : 1;
+    valign = valign > 8 ? 8 : valign;
+    
+    m->ksize = keysize;
+    m->vsize = valsize;
+    m->voff = (keysize+valign-1) & ~(valign-1);
+    m->stride = kalign > valign ? kalign : valign;
+    m->stride = (m->voff+valsize+m->stride-1) & ~(m->stride-1);
+    m->hash = hash;
+    m->cmp = cmp;
+    m->alloc = alloc;
+    m->status = ALG_STATUS_MALLOCED*malloced;
+    
+    RET(ALG_SUCCESS, m);
+}
+
+int hashmap_finish(struct hashmap *m)
+{
+    return hashmap_finish_custom(0, 0, m);
+}
+
+int hashmap_finish_custom(alg_foldfun fun, void *state, struct hashmap *m)
+{
+    hashmap_clear_custom(fun, state, m);
+    CATCHE(m);
+    
+    hashmap_intern_release(&m->table, m);
+    
+    if(m->status & ALG_STATUS_MALLOCED)
+        alg_free(m, m->alloc);
+    else
+        memset(m, 0, sizeof(struct hashmap));
+    
+    return ALG_SUCCESS;
+}
+
+void* hashmap_at(void *key, struct hashmap *m)
+{
+    unsigned long long hash;
+    int idx;
+    
+    if(!m)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    if(!key)
+        RETZ(ALG_ERROR_BAD_SOURCE, m);
+    
+    hash = hashmap_intern_hash(key, m);
+    
+    if(m->table.capacity && (idx = hashmap_intern_find(key, hash, &m->table, m)) >= 0)
+        RET(SLOT(&m->table, idx, m)+m->voff, m);
+    
+    if(m->old.capacity && (idx = hashmap_intern_find(key, hash, &m->old, m)) >= 0)
+        RET(SLOT(&m->old, idx, m)+m->voff, m);
+    
+    RETZ(ALG_ERROR_NOT_FOUND, m);
+}
+
+void* hashmap_get(void *key, void *dst, struct hashmap *m)
+{
+    void *ptr;
+    
+    if(!m)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    if(!dst)
+        RETZ(ALG_ERROR_BAD_DESTINATION, m);
+    
+    ptr = hashmap_at(key, m);
+    CATCHZ(m);
+    
+    memcpy(dst, ptr, m->vsize);
+    
+    RET(ptr, m);
+}
+
+int hashmap_size(struct hashmap *m)
+{
+    if(!m)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    RET(m->size, m);
+}
+
+void* hashmap_put(void *key, void *val, struct hashmap *m)
+{
+    unsigned long long hash;
+    void *ptr;
+    int idx;
+    
+    if(!m)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    if(!key)
+        RETZ(ALG_ERROR_BAD_SOURCE, m);
+    
+    hashmap_intern_migrate(ALG_HASHMAP_MIGRATE, m);
+    
+    ptr = hashmap_at(key, m);
+    
+    if(!ptr)
+    {
+        hashmap_intern_room(m);
+        CATCHZ(m);
+        
+        hash = hashmap_intern_hash(key, m);
+        idx = hashmap_intern_claim(hash, &m->table);
+        ptr = SLOT(&m->table, idx, m);
+        memcpy(ptr, key, m->ksize);
+        ptr += m->voff;
+        m->size++;
+    }
+    
+    if(val)
+        memcpy(ptr, val, m->vsize);
+    else
+        memset(ptr, 0, m->vsize);
+    
+    RET(ptr, m);
+}
+
+void hashmap_del(void *key, struct hashmap *m)
+{
+    hashmap_rem(key, 0, m);
+}
+
+void hashmap_rem(void *key, void *dst, struct hashmap *m)
+{
+    struct hashmap_table *t;
+    unsigned long long hash;
+    int idx = -1;
+    
+    if(!m)
+        RETV(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    if(!key)
+        RETV(ALG_ERROR_BAD_SOURCE, m);
+    
+    t = &m->table;
+    hashmap_intern_migrate(ALG_HASHMAP_MIGRATE, m);
+    
+    hash = hashmap_intern_hash(key, m);
+    
+    if(t->capacity)
+        idx = hashmap_intern_find(key, hash, t, m);
+    
+    if(idx < 0 && m->old.capacity)
+    {
+        t = &m->old;
+        idx = hashmap_intern_find(key, hash, t, m);
+    }
+    
+    if(idx < 0)
+        RETV(ALG_ERROR_NOT_FOUND, m);
+    
+    if(dst)
+        memcpy(dst, SLOT(t, idx, m)+m->voff, m->vsize);
+    
+    hashmap_intern_erase(idx, t);
+    m->size--;
+    m->error = ALG_SUCCESS;
+}
+
+void hashmap_reserve(int size, struct hashmap *m)
+{
+    int capacity;
+    
+    if(!m)
+        RETV(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    // the doubling below has to stop at a capacity int can still hold
+    if(size < 0 || size > LOAD_MAX(INT_MAX/2))
+        RETV(ALG_ERROR_BAD_SIZE, m);
+    
+    for(capacity=ALG_HASHMAP_GROUP; LOAD_MAX(capacity) <= size; capacity*=2);
+    
+    if(capacity <= m->table.capacity)
+        RETV(ALG_SUCCESS, m);
+    
+    // nothing is inserted meanwhile, so the move is done right away
+    hashmap_intern_rehash(capacity, m);
+    CATCHV(m);
+    hashmap_intern_migrate(-1, m);
+    
+    m->error = ALG_SUCCESS;
+}
+
+void hashmap_fold(alg_foldfun fun, void *state, struct hashmap *m)
+{
+    struct hashmap_table *t[2];
+    int i, j, pos = 0, ret;
+    
+    if(!m)
+        RETV(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    t[0] = &m->table;
+    t[1] = &m->old;
+    
+    for(j=0; j<2; j++)
+        for(i=0; i<t[j]->capacity; i++)
+            if(CTRL_FULL(t[j]->ctrl[i]))
+                if((ret = fun(pos++, SLOT(t[j], i, m), state)) != ALG_SUCCESS)
+                    RETV(ret, m);
+    
+    m->error = ALG_SUCCESS;
+}
+
+void hashmap_clear(struct hashmap *m)
+{
+    hashmap_clear_custom(0, 0, m);
+}
+
+void hashmap_clear_custom(alg_foldfun fun, void *state, struct hashmap *m)
+{
+    int i, pos = 0;
+    
+    if(!m)
+        RETV(ALG_ERROR_BAD_STRUCTURE, m);
+    
+    if(fun)
+    {
+        for(i=0; i<m->table.capacity; i++)
+            if(CTRL_FULL(m->table.ctrl[i]))
+                fun(pos++, SLOT(&m->table, i, m), state);
+        for(i=0; i<m->old.capacity; i++)
+            if(CTRL_FULL(m->old.ctrl[i]))
+                fun(pos++, SLOT(&m->old, i, m), state);
+    }
+    
+    hashmap_intern_release(&m->old, m);
+    
+    if(m->table.capacity)
+        memset(m->table.ctrl, CTRL_EMPTY, m->table.capacity);
+    m->table.used = 0;
+    m->table.tombs = 0;
+    m->migrated = 0;
+    m->size = 0;
+    m->error = ALG_SUCCESS;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+
+void show_hashmap(struct hashmap *m)
+{
+    printf("size: %i | capacity: %i | used: %i | tombs: %i", m->size,
+        m->table.capacity, m->table.used, m->table.tombs);
+    if(m->old.capacity)
+        printf(" | old: %i/%i migrated", m->migrated, m->old.capacity);
+    printf("\n");
+}
+
+int catch(struct hashmap *m)
+{
+    if(m->error != ALG_SUCCESS)
+    {
+        printf("error: %s\n", alg_str_error(m->error));
+        return 1;
+    }
+    return 0;
+}
+
+int test_sum(int pos, void *elem, void *state)
+{
+    *(long*)state += *(int*)elem;
+    return 0;
+}
+
+// all keys collide into the same group to exercise the probing
+unsigned long long test_hash(void *key, int size)
+{
+    return *(int*)key & 0x7f;
+}
+
+int test_cmp(void *a, void *b)
+{
+    return *(int*)a != *(int*)b;
+}
+
+int test_collide()
+{
+    struct hashmap *m = 0;
+    int i, j;
+    
+    if(hashmap_init_custom(sizeof(int), sizeof(int), test_hash, test_cmp, 0, &m) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<200; i++)
+    {
+        j = -i;
+        hashmap_put(&i, &j, m);
+    }
+    for(i=0; i<200; i+=2)
+        hashmap_del(&i, m);
+    for(i=0, j=0; i<200; i++)
+        j += hashmap_at(&i, m) && *(int*)hashmap_at(&i, m) == -i;
+    
+    printf("colliding: %i of 100 found | ", j);
+    show_hashmap(m);
+    
+    return hashmap_finish(m) != ALG_SUCCESS || j != 100;
+}
+
+int main(int argc, char *argv[])
+{
+    struct hashmap *m = 0;
+    int i, j, found;
+    long sum = 0;
+    
+    if(hashmap_init(sizeof(int), sizeof(int), &m) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+    {
+        j = i*i;
+        hashmap_put(&i, &j, m);
+        if(i == 14 || i == 16 || i == 700)
+            show_hashmap(m);
+    }
+    show_hashmap(m);
+    
+    i = 30;
+    hashmap_get(&i, &j, m);
+    printf("get 30: %i\n", j);
+    j = 7;
+    hashmap_put(&i, &j, m);
+    printf("overwrite 30: %i | size: %i\n", *(int*)hashmap_at(&i, m), hashmap_size(m));
+    
+    for(i=0; i<1000; i+=2)
+        hashmap_del(&i, m);
+    i = 30;
+    hashmap_at(&i, m);
+    catch(m);
+    hashmap_rem(&i, 0, m);
+    catch(m);
+    
+    for(i=1, found=0; i<1000; i+=2)
+        found += hashmap_get(&i, &j, m) && j == i*i;
+    printf("odd keys found: %i\n", found);
+    show_hashmap(m);
+    
+    hashmap_fold(test_sum, &sum, m);
+    printf("key sum: %li\n", sum);
+    
+    hashmap_clear(m);
+    hashmap_reserve(5000, m);
+    show_hashmap(m);
+    
+    hashmap_reserve(INT_MAX, m);
+    if(m->error != ALG_ERROR_BAD_SIZE)
+        return 1;
+    
+    if(hashmap_finish(m) != ALG_SUCCESS)
+        return 1;
+    
+    return test_collide();
+}
+
+#endif
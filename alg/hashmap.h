@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_HASHMAP_H__
+#define __ALG_HASHMAP_H__
+
+#include "fun.h"
+#include "alloc.h"
+
+#define ALG_HASHMAP_GROUP   16  // control bytes probed at once
+#define ALG_HASHMAP_MIGRATE 2   // groups moved per operation while rehashing
+
+// Open addressing after the Swiss table layout: a control byte per slot
+// holds 7 bits of the hash or marks the slot empty or deleted, probing
+// compares a whole group of control bytes at once. Slots hold the key
+// followed by the value at voff, fold functions get the key. Growing moves
+// the entries into the new table a few groups per operation.
+
+struct hashmap_table
+{
+    unsigned char *ctrl;
+    void *slots;
+    int capacity, used, tombs;
+};
+
+struct hashmap
+{
+    struct hashmap_table table, old;
+    alg_hashfun *hash;
+    alg_cmpfun *cmp;
+    struct alg_allocator *alloc;
+    int size, ksize, vsize, voff, stride, migrated, error;
+    char status;
+};
+
+int hashmap_init(int keysize, int valsize, struct hashmap **m);
+int hashmap_init_custom(int keysize, int valsize, alg_hashfun hash, alg_cmpfun cmp, struct alg_allocator *alloc, struct hashmap **m);
+int hashmap_finish(struct hashmap *m);
+int hashmap_finish_custom(alg_foldfun fun, void *state, struct hashmap *m);
+
+unsigned long long hashmap_hash(void *key, int size);
+
+void* hashmap_at(void *key, struct hashmap *m);
+void* hashmap_get(void *key, void *dst, struct hashmap *m);
+int   hashmap_size(struct hashmap *m);
+
+void* hashmap_put(void *key, void *val, struct hashmap *m);
+
+void hashmap_del(void *key, struct hashmap *m);
+void hashmap_rem(void *key, void *dst, struct hashmap *m);
+
+void hashmap_reserve(int size, struct hashmap *m);
+void hashmap_fold(alg_foldfun fun, void *state, struct hashmap *m);
+
+void hashmap_clear(struct hashmap *m);
+void hashmap_clear_custom(alg_foldfun fun, void *state, struct hashmap *m);
+
+#endif
@@ -23,8 +23,7 @@
 #ifndef __ALG_HELP_H__
 #define __ALG_HELP_H__
 
-#define ALG_STATUS_MALLOCED 1
-#define ALG_STATUS_INTERN   2
+#include "status.h"
 
 #define RET(ret, obj)   { (obj)->error = ALG_SUCCESS; return (ret); }
 #define RETV(err, obj)  { (obj)->error = (err); return; }
@@ -34,6 +33,13 @@
 #define CATCHZ(obj)     if((obj)->error != ALG_SUCCESS) return 0;
 #define CATCHE(obj)     if((obj)->error != ALG_SUCCESS) return (obj)->error;
 
+// accessors built with ALG_UNCHECKED skip their checks and the error store
+#ifdef ALG_UNCHECKED
+#define RETA(ret, obj)  return (ret);
+#else
+#define RETA(ret, obj)  RET(ret, obj)
+#endif
+
 #define RETI(i, e, obj) \
 { \
     (obj)->error = ALG_SUCCESS; \
@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_IO_H__
+#define __ALG_IO_H__
+
+#include "error.h"
+#include <errno.h>
+#include <string.h>
+#include <sys/uio.h>
+
+// Records are streamed behind a header of ALG_IO_HEAD bytes, the same one
+// mapped vector files start with, so a written vector can be mapped again.
+
+#define ALG_IO_MAGIC    "ALGVEC1"
+#define ALG_IO_HEAD     64      // same as ALG_VECTOR_FILE_HEAD
+#define ALG_IO_BATCH    256     // buffers per readv or writev call
+
+struct alg_io_head
+{
+    char magic[8];
+    long size;
+    int esize;
+};
+
+// transfers all count buffers, partial transfers continue where they
+// stopped, so iov is modified
+static inline int alg_io_intern_transfer(int fd, struct iovec *iov, int count, int write)
+{
+    ssize_t n;
+    
+    while(1)
+    {
+        for(; count && !iov->iov_len; iov++, count--);
+        if(!count)
+            return ALG_SUCCESS;
+        
+        if(write)
+            n = writev(fd, iov, count < ALG_IO_BATCH ? count : ALG_IO_BATCH);
+        else
+            n = readv(fd, iov, count < ALG_IO_BATCH ? count : ALG_IO_BATCH);
+        
+        if(n < 0 && errno == EINTR)
+            continue;
+        // nothing read is the end of file in the middle of a record
+        if(n <= 0)
+            return write ? ALG_ERROR_BAD_DESTINATION : ALG_ERROR_BAD_SOURCE;
+        
+        for(; count && (size_t)n >= iov->iov_len; n-=iov->iov_len, iov++, count--);
+        if(count)
+        {
+            iov->iov_base += n;
+            iov->iov_len -= n;
+        }
+    }
+}
+
+static inline int alg_io_writev(int fd, struct iovec *iov, int count)
+{
+    return alg_io_intern_transfer(fd, iov, count, 1);
+}
+
+static inline int alg_io_readv(int fd, struct iovec *iov, int count)
+{
+    return alg_io_intern_transfer(fd, iov, count, 0);
+}
+
+// head holds ALG_IO_HEAD bytes aligned for the struct it is written through
+static inline void alg_io_head_init(long size, int esize, char *head)
+{
+    struct alg_io_head *h = (struct alg_io_head*)head;
+    
+    memset(head, 0, ALG_IO_HEAD);
+    memcpy(h->magic, ALG_IO_MAGIC, sizeof(h->magic));
+    h->size = size;
+    h->esize = esize;
+}
+
+// reads and checks a header, returns the record count or an error
+static inline long alg_io_head_read(int fd, int esize)
+{
+    char head[ALG_IO_HEAD] __attribute__((aligned(8)));
+    struct alg_io_head *h = (struct alg_io_head*)head;
+    struct iovec iov = {head, ALG_IO_HEAD};
+    int ret;
+    
+    if((ret = alg_io_readv(fd, &iov, 1)) != ALG_SUCCESS)
+        return ret;
+    
+    if(memcmp(h->magic, ALG_IO_MAGIC, sizeof(h->magic)) || h->size < 0)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if(h->esize != esize)
+        return ALG_ERROR_BAD_SIZE;
+    
+    return h->size;
+}
+
+#endif
@@ -0,0 +1,398 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_ITER_H__
+#define __ALG_ITER_H__
+
+#include "error.h"
+#include "fun.h"
+#include "vector.h"
+#include "list.h"
+#include <string.h>
+
+#define ALG_ITER_STAGES 8
+#define ALG_ITER_BATCH  256     // elements handed to a stage at once in batched mode
+#define ALG_ITER_BUFFER 16384   // stack bytes for the copies map stages work on
+
+#define ALG_ITER_MAP    1
+#define ALG_ITER_FILTER 2
+#define ALG_ITER_TAKE   3
+
+// Lazy pipelines over a vector or a list. Stages are only recorded until a
+// fold runs them, every element then passes all stages in one traversal
+// without any intermediate container. Maps work on a copy on the stack, so
+// the source stays untouched.
+//
+//     struct alg_iter it;
+//     alg_iter_vector(vec, &it);
+//     alg_iter_filter(is_odd, 0, &it);
+//     alg_iter_map(square, &it);
+//     alg_iter_take(10, &it);
+//     count = alg_iter_fold(sum, &total, &it);
+//
+// alg_iter_fold calls every stage per element, alg_iter_fold_n hands blocks
+// of up to ALG_ITER_BATCH element pointers to the _n stages and the final
+// fold. Both kinds of stages work in both modes. Filters keep elements they
+// return a positive value for and see the source position, the fold sees
+// the output position and stops early on a positive value. Any negative
+// value ends the run with that error, otherwise the folded count is returned.
+
+typedef int alg_iter_mapfun(void **elems, int count, void *state);
+typedef int alg_iter_filterfun(void **elems, int count, char *keep, void *state);
+typedef int alg_iter_foldfun(void **elems, int count, void *state);
+
+struct alg_iter_stage
+{
+    alg_mapfun *map;
+    alg_foldfun *filter;
+    alg_iter_mapfun *mapn;
+    alg_iter_filterfun *filtern;
+    void *state;
+    int type, limit, passed;
+};
+
+struct alg_iter
+{
+    struct vector *vec;
+    struct list *list;
+    struct alg_iter_stage stages[ALG_ITER_STAGES];
+    int count, esize, maps;
+};
+
+static inline int alg_iter_vector(struct vector *vec, struct alg_iter *it)
+{
+    if(!it || !vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    memset(it, 0, sizeof(struct alg_iter));
+    it->vec = vec;
+    it->esize = vec->esize;
+    
+    return ALG_SUCCESS;
+}
+
+static inline int alg_iter_list(struct list *l, struct alg_iter *it)
+{
+    if(!it || !l)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    memset(it, 0, sizeof(struct alg_iter));
+    it->list = l;
+    it->esize = l->esize;
+    
+    return ALG_SUCCESS;
+}
+
+static inline struct alg_iter_stage* alg_iter_intern_stage(int type, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(!it || it->count == ALG_ITER_STAGES)
+        return 0;
+    
+    s = &it->stages[it->count++];
+    memset(s, 0, sizeof(struct alg_iter_stage));
+    s->type = type;
+    it->maps += type == ALG_ITER_MAP;
+    
+    return s;
+}
+
+static inline int alg_iter_map(alg_mapfun fun, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    if(!(s = alg_iter_intern_stage(ALG_ITER_MAP, it)))
+        return it ? ALG_ERROR_FULL : ALG_ERROR_BAD_STRUCTURE;
+    
+    s->map = fun;
+    return ALG_SUCCESS;
+}
+
+static inline int alg_iter_map_n(alg_iter_mapfun fun, void *state, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    if(!(s = alg_iter_intern_stage(ALG_ITER_MAP, it)))
+        return it ? ALG_ERROR_FULL : ALG_ERROR_BAD_STRUCTURE;
+    
+    s->mapn = fun;
+    s->state = state;
+    return ALG_SUCCESS;
+}
+
+static inline int alg_iter_filter(alg_foldfun fun, void *state, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    if(!(s = alg_iter_intern_stage(ALG_ITER_FILTER, it)))
+        return it ? ALG_ERROR_FULL : ALG_ERROR_BAD_STRUCTURE;
+    
+    s->filter = fun;
+    s->state = state;
+    return ALG_SUCCESS;
+}
+
+static inline int alg_iter_filter_n(alg_iter_filterfun fun, void *state, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    if(!(s = alg_iter_intern_stage(ALG_ITER_FILTER, it)))
+        return it ? ALG_ERROR_FULL : ALG_ERROR_BAD_STRUCTURE;
+    
+    s->filtern = fun;
+    s->state = state;
+    return ALG_SUCCESS;
+}
+
+static inline int alg_iter_take(int count, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    
+    if(count < 0)
+        return ALG_ERROR_BAD_SIZE;
+    if(!(s = alg_iter_intern_stage(ALG_ITER_TAKE, it)))
+        return it ? ALG_ERROR_FULL : ALG_ERROR_BAD_STRUCTURE;
+    
+    s->limit = count;
+    return ALG_SUCCESS;
+}
+
+static inline void* alg_iter_intern_first(struct alg_iter *it)
+{
+    if(it->vec)
+        return it->vec->size ? it->vec->mem : 0;
+    return list_first_unchecked(it->list);
+}
+
+static inline void* alg_iter_intern_next(void *elem, struct alg_iter *it)
+{
+    if(it->vec)
+        return elem+it->esize < it->vec->pos ? elem+it->esize : 0;
+    return list_next_unchecked(elem);
+}
+
+// checks the pipeline and rewinds its take stages
+static inline int alg_iter_intern_start(struct alg_iter *it)
+{
+    int i;
+    
+    if(!it || (!it->vec && !it->list))
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(it->maps && it->esize > ALG_ITER_BUFFER)
+        return ALG_ERROR_BAD_SIZE;
+    
+    for(i=0; i<it->count; i++)
+        it->stages[i].passed = 0;
+    
+    return ALG_SUCCESS;
+}
+
+// one element through all stages, 1 if it comes out at the end, 0 if
+// dropped, done is set once a take stage lets nothing through any more
+static inline int alg_iter_intern_step(void **elem, int pos, char *tmp, int *done, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    int i, ret, copied = 0;
+    char keep;
+    
+    for(i=0, s=it->stages; i<it->count; i++, s++)
+    {
+        switch(s->type)
+        {
+            case ALG_ITER_MAP:
+                if(!copied)
+                {
+                    memcpy(tmp, *elem, it->esize);
+                    *elem = tmp;
+                    copied = 1;
+                }
+                ret = s->map ? s->map(*elem) : s->mapn(elem, 1, s->state);
+                if(ret < 0)
+                    return ret;
+                break;
+            case ALG_ITER_FILTER:
+                if(s->filter)
+                    ret = s->filter(pos, *elem, s->state);
+                else if((ret = s->filtern(elem, 1, &keep, s->state)) >= 0)
+                    ret = keep;
+                if(ret <= 0)
+                    return ret;
+                break;
+            case ALG_ITER_TAKE:
+                if(s->passed == s->limit)
+                {
+                    *done = 1;
+                    return 0;
+                }
+                if(++s->passed == s->limit)
+                    *done = 1;
+                break;
+        }
+    }
+    
+    return 1;
+}
+
+static inline int alg_iter_fold(alg_foldfun fun, void *state, struct alg_iter *it)
+{
+    char tmp[it && it->maps && it->esize <= ALG_ITER_BUFFER ? it->esize : 1] __attribute__((aligned(16)));
+    void *elem, *cur;
+    int ret, pos, count = 0, done = 0;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if((ret = alg_iter_intern_start(it)) != ALG_SUCCESS)
+        return ret;
+    
+    for(cur=alg_iter_intern_first(it), pos=0; cur && !done; cur=alg_iter_intern_next(cur, it), pos++)
+    {
+        elem = cur;
+        if((ret = alg_iter_intern_step(&elem, pos, tmp, &done, it)) < 0)
+            return ret;
+        if(!ret)
+            continue;
+        
+        if((ret = fun(count++, elem, state)) < 0)
+            return ret;
+        if(ret > 0)
+            break;
+    }
+    
+    return count;
+}
+
+// the block through all stages, returns how many elements are left in it
+static inline int alg_iter_intern_block(void **elems, int *pos, int n, char *tmp, int *done, struct alg_iter *it)
+{
+    struct alg_iter_stage *s;
+    char keep[ALG_ITER_BATCH];
+    int i, k, m, ret = ALG_SUCCESS, copied = 0;
+    
+    for(i=0, s=it->stages; i<it->count && n; i++, s++)
+    {
+        switch(s->type)
+        {
+            case ALG_ITER_MAP:
+                if(!copied)
+                {
+                    for(k=0; k<n; k++)
+                    {
+                        memcpy(tmp+k*it->esize, elems[k], it->esize);
+                        elems[k] = tmp+k*it->esize;
+                    }
+                    copied = 1;
+                }
+                if(s->mapn)
+                    ret = s->mapn(elems, n, s->state);
+                else
+                    for(k=0; k<n && ret >= 0; k++)
+                        ret = s->map(elems[k]);
+                if(ret < 0)
+                    return ret;
+                break;
+            case ALG_ITER_FILTER:
+                if(s->filtern)
+                {
+                    if((ret = s->filtern(elems, n, keep, s->state)) < 0)
+                        return ret;
+                }
+                else
+                    for(k=0; k<n; k++)
+                    {
+                        if((ret = s->filter(pos[k], elems[k], s->state)) < 0)
+                            return ret;
+                        keep[k] = ret > 0;
+                    }
+                for(k=0, m=0; k<n; k++)
+                    if(keep[k])
+                    {
+                        elems[m] = elems[k];
+                        pos[m++] = pos[k];
+                    }
+                n = m;
+                break;
+            case ALG_ITER_TAKE:
+                if(n >= s->limit-s->passed)
+                {
+                    n = s->limit-s->passed;
+                    *done = 1;
+                }
+                s->passed += n;
+                break;
+        }
+    }
+    
+    return n;
+}
+
+static inline int alg_iter_fold_n(alg_iter_foldfun fun, void *state, struct alg_iter *it)
+{
+    char tmp[it && it->maps ? ALG_ITER_BUFFER : 1] __attribute__((aligned(16)));
+    void *elems[ALG_ITER_BATCH], *cur;
+    int pos[ALG_ITER_BATCH];
+    int n, ret, index = 0, batch = ALG_ITER_BATCH, count = 0, done = 0;
+    
+    if(!fun)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if((ret = alg_iter_intern_start(it)) != ALG_SUCCESS)
+        return ret;
+    
+    // mapped copies of a whole block have to fit the buffer
+    if(it->maps && batch > ALG_ITER_BUFFER/it->esize)
+        batch = ALG_ITER_BUFFER/it->esize;
+    
+    for(cur=alg_iter_intern_first(it); cur && !done; )
+    {
+        for(n=0; n<batch && cur; n++, index++, cur=alg_iter_intern_next(cur, it))
+        {
+            elems[n] = cur;
+            pos[n] = index;
+        }
+        
+        if((n = alg_iter_intern_block(elems, pos, n, tmp, &done, it)) < 0)
+            return n;
+        if(!n)
+            continue;
+        
+        if((ret = fun(elems, n, state)) < 0)
+            return ret;
+        count += n;
+        if(ret > 0)
+            break;
+    }
+    
+    return count;
+}
+
+#endif
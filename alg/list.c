@@ -21,10 +21,14 @@
  */
 
 #include "list.h"
+#include "alloc.h"
 #include "error.h"
 #include "help.h"
+#include "thread.h"
+#include "io.h"
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 
 struct list_fold_state
 {
@@ -32,36 +36,337 @@ struct list_fold_state
     void *state;
 };
 
+struct list_sort_state
+{
+    struct list_elem *a, *b;
+    alg_cmpfun *cmp;
+};
+
 struct list_elem* list_intern_get(int pos, struct list *l)
 {
     struct list_elem *elem;
+    int dist;
     
+    // walk from whichever of first, last and the finger is nearest
     if(pos >= l->size/2)
     {
-        pos = l->size - pos -1;
         elem = l->last;
-        while(elem && --pos >= 0)
-            elem = elem->prev;
+        dist = pos - l->size +1;
     }
     else
     {
         elem = l->first;
-        while(elem && --pos >= 0)
-            elem = elem->next;
+        dist = pos;
     }
+    if(l->finger && abs(pos - l->fingerpos) < abs(dist))
+    {
+        elem = l->finger;
+        dist = pos - l->fingerpos;
+    }
+    
+    ALG_STAT(l, hops, abs(dist));
+    
+    for(; dist > 0; dist--)
+        elem = elem->next;
+    for(; dist < 0; dist++)
+        elem = elem->prev;
+    
+    l->finger = elem;
+    l->fingerpos = pos;
     
     RET(elem, l);
 }
 
-struct list_elem* list_intern_gen(void *elem, struct list *l)
+int list_intern_nodesize(struct list *l)
+{
+    int size = sizeof(struct list_elem)+l->esize;
+    return (size+sizeof(void*)-1) & ~(sizeof(void*)-1);
+}
+
+// a pool only the list itself points to, nobody else can change that, so
+// it is used without locking
+int list_intern_private(struct list_pool *pool)
+{
+    return !atomic_load_explicit(&pool->parent, memory_order_acquire)
+        && atomic_load_explicit(&pool->refs, memory_order_acquire) == 1;
+}
+
+// the root of the pool family, locked if other lists use it as well, merges
+// set the parent of a root under its lock, so a root found without parent
+// while locked stays the root until unlocked
+struct list_pool* list_intern_lock(int *locked, struct list *l)
+{
+    struct list_pool *pool = l->pool, *parent;
+    
+    *locked = !list_intern_private(pool);
+    if(!*locked)
+        return pool;
+    
+    while(1)
+    {
+        while((parent = atomic_load_explicit(&pool->parent, memory_order_acquire)))
+            pool = parent;
+        pthread_mutex_lock(&pool->lock);
+        if(!atomic_load_explicit(&pool->parent, memory_order_relaxed))
+            return pool;
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+void list_intern_unlock(int locked, struct list_pool *pool)
+{
+    if(locked)
+        pthread_mutex_unlock(&pool->lock);
+}
+
+// drops a reference, pools without any are freed and release their parent
+void list_intern_unref(struct list_pool *pool, struct list *l)
+{
+    struct list_pool *parent;
+    struct list_slab *slab, *next;
+    
+    for(; pool && atomic_fetch_sub_explicit(&pool->refs, 1, memory_order_acq_rel) == 1; pool=parent)
+    {
+        parent = atomic_load_explicit(&pool->parent, memory_order_relaxed);
+        for(slab=pool->slabs; slab; slab=next)
+        {
+            next = slab->next;
+            alg_free(slab, l->alloc);
+            ALG_STAT(l, frees, 1);
+        }
+        pthread_mutex_destroy(&pool->lock);
+        alg_free(pool, l->alloc);
+    }
+}
+
+// the root of the pool the list allocates from, created on first use,
+// merged pools are skipped by pointing the list at the root directly, the
+// pools in between keep it alive until the list holds its own reference
+struct list_pool* list_intern_pool(struct list *l)
+{
+    struct list_pool *pool = l->pool, *parent;
+    
+    if(!pool)
+    {
+        pool = alg_alloc(sizeof(struct list_pool), l->alloc);
+        if(!pool)
+            RETZ(ALG_ERROR_NO_MEMORY, l);
+        memset(pool, 0, sizeof(struct list_pool));
+        pthread_mutex_init(&pool->lock, 0);
+        atomic_init(&pool->parent, 0);
+        atomic_init(&pool->refs, 1);
+        l->pool = pool;
+    }
+    
+    if(atomic_load_explicit(&pool->parent, memory_order_acquire))
+    {
+        while((parent = atomic_load_explicit(&pool->parent, memory_order_acquire)))
+            pool = parent;
+        atomic_fetch_add_explicit(&pool->refs, 1, memory_order_relaxed);
+        list_intern_unref(l->pool, l);
+        l->pool = pool;
+    }
+    
+    RET(pool, l);
+}
+
+// a list without nodes owes nothing to a shared pool, dropping its reference
+// uncouples it from the other lists, the next node comes from a fresh pool
+void list_intern_decouple(struct list *l)
+{
+    if(l->size || !l->pool)
+        return;
+    
+    if(!list_intern_private(l->pool))
+    {
+        list_intern_unref(l->pool, l);
+        l->pool = 0;
+    }
+}
+
+// lists exchanging nodes have to allocate from the same pool, the slabs
+// and free nodes of one root are handed to the other in constant time,
+// both roots are locked in address order as other threads may use them
+void list_intern_share(struct list *src, struct list *l)
+{
+    struct list_pool *from, *to, *first, *second;
+    
+    if(src->esize != l->esize)
+        RETV(ALG_ERROR_BAD_SIZE, l);
+    
+    if(src->alloc != l->alloc)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    to = list_intern_pool(l);
+    CATCHV(l);
+    
+    if(!src->pool)
+    {
+        atomic_fetch_add_explicit(&to->refs, 1, memory_order_relaxed);
+        src->pool = to;
+        RETV(ALG_SUCCESS, l);
+    }
+    
+    while(1)
+    {
+        from = list_intern_pool(src);
+        to = list_intern_pool(l);
+        if(from == to)
+            RETV(ALG_SUCCESS, l);
+        
+        first = from < to ? from : to;
+        second = from < to ? to : from;
+        pthread_mutex_lock(&first->lock);
+        pthread_mutex_lock(&second->lock);
+        if(!atomic_load_explicit(&from->parent, memory_order_relaxed)
+            && !atomic_load_explicit(&to->parent, memory_order_relaxed))
+            break;
+        pthread_mutex_unlock(&second->lock);
+        pthread_mutex_unlock(&first->lock);
+    }
+    
+    if(from->slabs)
+    {
+        if(to->slabs)
+            to->oldest->next = from->slabs;
+        else
+            to->slabs = from->slabs;
+        to->oldest = from->oldest;
+    }
+    
+    if(from->free)
+    {
+        from->lastfree->next = to->free;
+        if(!to->free)
+            to->lastfree = from->lastfree;
+        to->free = from->free;
+    }
+    
+    from->slabs = 0;
+    from->free = 0;
+    atomic_fetch_add_explicit(&to->refs, 1, memory_order_relaxed);
+    atomic_store_explicit(&from->parent, to, memory_order_release);
+    
+    pthread_mutex_unlock(&second->lock);
+    pthread_mutex_unlock(&first->lock);
+    
+    l->error = ALG_SUCCESS;
+}
+
+struct list_elem* list_intern_alloc(struct list *l)
+{
+    struct list_pool *pool;
+    struct list_slab *slab;
+    struct list_elem *lelem;
+    int count, nodesize, locked;
+    
+    list_intern_pool(l);
+    CATCHZ(l);
+    
+    pool = list_intern_lock(&locked, l);
+    
+    if(pool->free)
+    {
+        lelem = pool->free;
+        pool->free = lelem->next;
+        list_intern_unlock(locked, pool);
+        RET(lelem, l);
+    }
+    
+    nodesize = list_intern_nodesize(l);
+    slab = pool->slabs;
+    
+    if(!slab || slab->used == slab->count)
+    {
+        // every new slab doubles the node count up to ALG_LIST_SLAB_MAX
+        count = slab ? slab->count*2 : ALG_LIST_SLAB;
+        if(count > ALG_LIST_SLAB_MAX)
+            count = ALG_LIST_SLAB_MAX;
+        
+        slab = alg_alloc(sizeof(struct list_slab)+count*nodesize, l->alloc);
+        ALG_STAT(l, allocs, 1);
+        if(!slab)
+        {
+            list_intern_unlock(locked, pool);
+            RETZ(ALG_ERROR_NO_MEMORY, l);
+        }
+        
+        slab->count = count;
+        slab->used = 0;
+        slab->next = pool->slabs;
+        if(!pool->slabs)
+            pool->oldest = slab;
+        pool->slabs = slab;
+    }
+    
+    lelem = (struct list_elem*)(slab->mem+slab->used*nodesize);
+    slab->used++;
+    
+    list_intern_unlock(locked, pool);
+    RET(lelem, l);
+}
+
+// gives back the chain first..last linked by next in one go
+void list_intern_free_n(struct list_elem *first, struct list_elem *last, struct list *l)
+{
+    struct list_pool *pool;
+    int locked;
+    
+    // nodes only exist with a pool, which merging can only have moved up
+    pool = list_intern_lock(&locked, l);
+    
+    if(!pool->free)
+        pool->lastfree = last;
+    last->next = pool->free;
+    pool->free = first;
+    
+    list_intern_unlock(locked, pool);
+}
+
+void list_intern_free(struct list_elem *lelem, struct list *l)
+{
+    list_intern_free_n(lelem, lelem, l);
+}
+
+// gives back all nodes of the list, a pool of its own is emptied slab wise
+// keeping the newest and largest slab, a shared one gets the chain at once
+void list_intern_release(struct list *l)
 {
-    struct list_elem* lelem = malloc(sizeof(struct list_elem));
-    if(!lelem)
-        RETZ(ALG_ERROR_NO_MEMORY, l);
+    struct list_pool *pool;
+    struct list_slab *slab, *next;
+    
+    if(!l->pool)
+        return;
+    
+    pool = list_intern_pool(l);
     
-    lelem->elem = malloc(l->esize);
-    if(!lelem->elem)
-        RETZ(ALG_ERROR_NO_MEMORY, l);
+    if(!list_intern_private(pool))
+    {
+        if(l->first)
+            list_intern_free_n(l->first, l->last, l);
+        return;
+    }
+    
+    if(!pool->slabs)
+        return;
+    
+    for(slab=pool->slabs->next; slab; slab=next)
+    {
+        next = slab->next;
+        alg_free(slab, l->alloc);
+        ALG_STAT(l, frees, 1);
+    }
+    
+    pool->slabs->next = 0;
+    pool->slabs->used = 0;
+    pool->oldest = pool->slabs;
+    pool->free = 0;
+}
+
+struct list_elem* list_intern_gen(void *elem, struct list *l)
+{
+    struct list_elem* lelem = list_intern_alloc(l);
+    CATCHZ(l);
     
     lelem->next = 0;
     lelem->prev = 0;
@@ -74,10 +379,9 @@ struct list_elem* list_intern_gen(void *elem, struct list *l)
     RET(lelem, l);
 }
 
-struct list_elem* list_intern_add(void *elem, struct list *l)
+void list_intern_append(struct list_elem *lelem, struct list *l)
 {
-    struct list_elem *lelem = list_intern_gen(elem, l);
-    CATCHZ(l);
+    lelem->next = 0;
     
     if(!l->first)
     {
@@ -93,12 +397,68 @@ struct list_elem* list_intern_add(void *elem, struct list *l)
     }
     
     (l->size)++;
+}
+
+struct list_elem* list_intern_add(void *elem, struct list *l)
+{
+    struct list_elem *lelem = list_intern_gen(elem, l);
+    CATCHZ(l);
+    
+    list_intern_append(lelem, l);
     
     return lelem;
 }
 
-void list_intern_remove(struct list_elem *elem, struct list *l)
+// inserts the chain first..last of count nodes in front of pos,
+// pos equal to the size appends without touching the finger
+void list_intern_link(int pos, struct list_elem *first, struct list_elem *last, int count, struct list *l)
 {
+    struct list_elem *felem;
+    
+    if(pos == l->size)
+    {
+        first->prev = l->last;
+        last->next = 0;
+        if(l->last)
+            l->last->next = first;
+        else
+            l->first = first;
+        l->last = last;
+    }
+    else
+    {
+        felem = list_intern_get(pos, l);
+        first->prev = felem->prev;
+        last->next = felem;
+        if(felem->prev)
+            felem->prev->next = first;
+        else
+            l->first = first;
+        felem->prev = last;
+        l->fingerpos += count;
+    }
+    
+    l->size += count;
+}
+
+// takes the node out of the list without giving it back to the pool
+void list_intern_unlink(struct list_elem *elem, struct list *l)
+{
+    // the finger moves on to the successor which takes over its position,
+    // removing any other node but the last shifts it by an unknown amount
+    if(elem == l->finger)
+    {
+        if(elem->next)
+            l->finger = elem->next;
+        else
+        {
+            l->finger = elem->prev;
+            l->fingerpos--;
+        }
+    }
+    else if(elem != l->last)
+        l->finger = 0;
+    
     if(!elem->prev)
         l->first = elem->next;
     else
@@ -109,12 +469,98 @@ void list_intern_remove(struct list_elem *elem, struct list *l)
     else
         elem->next->prev = elem->prev;
     
-    free(elem->elem);
-    free(elem);
-    
     (l->size)--;
 }
 
+void list_intern_remove(struct list_elem *elem, struct list *l)
+{
+    list_intern_unlink(elem, l);
+    list_intern_free(elem, l);
+    list_intern_decouple(l);
+}
+
+// merges two sorted chains terminated by a null next, ties take a first
+struct list_elem* list_intern_merge(struct list_elem *a, struct list_elem *b, alg_cmpfun cmp)
+{
+    struct list_elem *head = 0, **tail = &head;
+    
+    while(a && b)
+    {
+        if(cmp(b->elem, a->elem) < 0)
+        {
+            *tail = b;
+            b = b->next;
+        }
+        else
+        {
+            *tail = a;
+            a = a->next;
+        }
+        tail = &(*tail)->next;
+    }
+    *tail = a ? a : b;
+    
+    return head;
+}
+
+// bottom up merge sort of a chain, bin i holds a sorted run of 2^i nodes
+// which is always older than the runs in lower bins
+struct list_elem* list_intern_msort(struct list_elem *chain, alg_cmpfun cmp)
+{
+    struct list_elem *bins[sizeof(int)*8], *run, *next;
+    int i, top = 0;
+    
+    memset(bins, 0, sizeof(bins));
+    
+    for(; chain; chain=next)
+    {
+        next = chain->next;
+        chain->next = 0;
+        run = chain;
+        
+        for(i=0; bins[i]; i++)
+        {
+            run = list_intern_merge(bins[i], run, cmp);
+            bins[i] = 0;
+        }
+        bins[i] = run;
+        if(i > top)
+            top = i;
+    }
+    
+    for(run=0, i=0; i<=top; i++)
+        if(bins[i])
+            run = list_intern_merge(bins[i], run, cmp);
+    
+    return run;
+}
+
+void* list_intern_msort_par(void *arg)
+{
+    struct list_sort_state *s = arg;
+    s->a = list_intern_msort(s->a, s->cmp);
+    return 0;
+}
+
+void* list_intern_merge_par(void *arg)
+{
+    struct list_sort_state *s = arg;
+    s->a = list_intern_merge(s->a, s->b, s->cmp);
+    return 0;
+}
+
+// restores the prev links and the ends after the chain was sorted
+void list_intern_relink(struct list_elem *chain, struct list *l)
+{
+    struct list_elem *prev = 0;
+    
+    l->first = chain;
+    for(; chain; prev=chain, chain=chain->next)
+        chain->prev = prev;
+    l->last = prev;
+    l->finger = 0;
+}
+
 struct list_elem* list_intern_iterate(alg_foldfun fun, void *state, struct list *l)
 {
     struct list_elem* current = l->first;
@@ -126,11 +572,17 @@ struct list_elem* list_intern_iterate(alg_foldfun fun, void *state, struct list
         if(ret < 0)
             RETZ(ret, l);
         if(ret > 0)
+        {
+            ALG_STAT(l, hops, pos);
+            l->finger = current;
+            l->fingerpos = pos;
             RET(current, l);
+        }
         current = current->next;
         pos++;
     }
     
+    ALG_STAT(l, hops, pos);
     RETZ(ALG_ERROR_NOT_FOUND, l);
 }
 
@@ -144,6 +596,11 @@ int list_intern_fold(int pos, void *elem, void *vstate)
 }
 
 int list_init(int elemsize, struct list **pl)
+{
+    return list_init_alloc(elemsize, 0, pl);
+}
+
+int list_init_alloc(int elemsize, struct alg_allocator *alloc, struct list **pl)
 {
     int malloced = 0;
     struct list *l;
@@ -157,7 +614,7 @@ int list_init(int elemsize, struct list **pl)
     if(!*pl)
     {
         malloced = 1;
-        *pl = malloc(sizeof(struct list));
+        *pl = alg_alloc(sizeof(struct list), alloc);
         if(!*pl)
             return ALG_ERROR_NO_MEMORY;
     }
@@ -168,7 +625,12 @@ int list_init(int elemsize, struct list **pl)
     l->first = 0;
     l->last = 0;
     l->current = 0;
+    l->finger = 0;
+    l->fingerpos = 0;
+    l->pool = 0;
+    l->alloc = alloc;
     l->status = ALG_STATUS_MALLOCED*malloced;
+    memset(&l->stats, 0, sizeof(struct alg_stats));
     
     RET(ALG_SUCCESS, l);
 }
@@ -180,11 +642,13 @@ int list_finish(struct list *l)
 
 int list_finish_custom(alg_foldfun *fun, void *state, struct list *l)
 {
-    list_clear(l);
+    list_clear_custom(fun, state, l);
     CATCHE(l);
     
+    list_intern_unref(l->pool, l);
+    
     if(l->status & ALG_STATUS_MALLOCED)
-        free(l);
+        alg_free(l, l->alloc);
     else
         memset(l, 0, sizeof(struct list));
     
@@ -209,7 +673,7 @@ void* list_at(int pos, struct list *l)
 void* list_at_c(int pos, struct list *l)
 {
     struct list_elem *lelem;
-    EXEC_INTERN(lelem = list_at_c(pos, l), l);
+    EXEC_INTERN(lelem = list_at(pos, l), l);
     CATCHZ(l);
     l->current = lelem;
     return lelem->elem;
@@ -238,7 +702,7 @@ void* list_get(int pos, void *dst, struct list *l)
 void* list_get_c(int pos, void *dst, struct list *l)
 {
     struct list_elem *lelem;
-    EXEC_INTERN(lelem = list_get_c(pos, dst, l), l);
+    EXEC_INTERN(lelem = list_get(pos, dst, l), l);
     CATCHZ(l);
     l->current = lelem;
     return lelem->elem;
@@ -260,7 +724,7 @@ void* list_find(alg_foldfun fun, void *state, struct list *l)
 void* list_find_c(alg_foldfun fun, void *state, struct list *l)
 {
     struct list_elem *lelem;
-    EXEC_INTERN(lelem = list_find_c(fun, state, l), l);
+    EXEC_INTERN(lelem = list_find(fun, state, l), l);
     CATCHZ(l);
     l->current = lelem;
     return lelem->elem;
@@ -279,24 +743,28 @@ void* list_current(struct list *l)
 
 void* list_first(struct list *l)
 {
+#ifndef ALG_UNCHECKED
     if(!l)
         RETZ(ALG_ERROR_BAD_STRUCTURE, l);
     
     if(!l->first)
         RETZ(ALG_ERROR_EMPTY, l);
+#endif
     
-    RET(l->first->elem, l);
+    RETA(list_first_unchecked(l), l);
 }
 
 void* list_last(struct list *l)
 {
+#ifndef ALG_UNCHECKED
     if(!l)
         RETZ(ALG_ERROR_BAD_STRUCTURE, l);
     
     if(!l->last)
         RETZ(ALG_ERROR_EMPTY, l);
+#endif
     
-    RET(l->last->elem, l);
+    RETA(list_last_unchecked(l), l);
 }
 
 void* list_next(struct list *l)
@@ -347,10 +815,12 @@ void* list_prev_c(struct list *l)
 
 int list_size(struct list *l)
 {
+#ifndef ALG_UNCHECKED
     if(!l)
         RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+#endif
     
-    RET(l->size, l);
+    RETA(l->size, l);
 }
 
 void* list_push(void *elem, struct list *l)
@@ -366,6 +836,21 @@ void* list_push(void *elem, struct list *l)
     RETI(lelem, lelem->elem, l);
 }
 
+void* list_emplace(struct list *l)
+{
+    struct list_elem *lelem;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    lelem = list_intern_alloc(l);
+    CATCHZ(l);
+    
+    list_intern_append(lelem, l);
+    
+    RET(lelem->elem, l);
+}
+
 void* list_push_c(void *elem, struct list *l)
 {
     struct list_elem *lelem;
@@ -398,7 +883,10 @@ void* list_ins(int pos, void *elem, struct list* l)
     lelem->next = felem;
     felem->prev = lelem;
     (l->size)++;
-    return lelem;
+    
+    l->finger = lelem;
+    
+    RETI(lelem, lelem->elem, l);
 }
 
 void* list_ins_c(int pos, void *elem, struct list* l)
@@ -464,6 +952,7 @@ void* list_ins_before(alg_foldfun fun, void *state, void *elem, struct list *l)
     felem->prev = lelem;
     lelem->next = felem;
     (l->size)++;
+    l->fingerpos++;
     RETI(lelem, lelem->elem, l);
 }
 
@@ -614,50 +1103,415 @@ void list_find_rem_custom(alg_foldfun ffun, void *state, void *dst, alg_mapfun d
     l->error = ALG_SUCCESS;
 }
 
-void list_fold(alg_foldfun fun, void *state, struct list *l)
-{
-    struct list_fold_state fstate;
-    fstate.fun = fun;
-    fstate.state = state;
-    list_intern_iterate(list_intern_fold, &fstate, l);
-    if(l->error == ALG_ERROR_NOT_FOUND)
-        l->error = ALG_SUCCESS;
-}
-
-void list_clear(struct list *l)
+int list_remove_if(alg_foldfun fun, void *state, struct list *l)
 {
-    list_clear_custom(0, 0, l);
+    struct list_elem *elem, *next, *prev = 0, *first = 0, *last = 0;
+    int pos, ret = ALG_SUCCESS, removed = 0;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!fun)
+        RETZ(ALG_ERROR_BAD_SOURCE, l);
+    
+    // kept nodes are linked up behind prev, removed ones are collected in
+    // a chain which goes back to the pool as a whole
+    for(elem=l->first, pos=0; elem; elem=next, pos++)
+    {
+        next = elem->next;
+        
+        if((ret = fun(pos, elem->elem, state)) < 0)
+            break;
+        
+        if(ret > 0)
+        {
+            if(elem == l->current)
+                l->current = 0;
+            elem->next = first;
+            first = elem;
+            if(!last)
+                last = elem;
+            removed++;
+            continue;
+        }
+        
+        elem->prev = prev;
+        if(prev)
+            prev->next = elem;
+        else
+            l->first = elem;
+        prev = elem;
+    }
+    
+    // a failing predicate leaves the rest as it is
+    if(elem)
+        elem->prev = prev;
+    if(prev)
+        prev->next = elem;
+    else
+        l->first = elem;
+    if(!elem)
+        l->last = prev;
+    
+    if(removed)
+    {
+        list_intern_free_n(first, last, l);
+        l->size -= removed;
+        l->finger = 0;
+        list_intern_decouple(l);
+    }
+    
+    // nodes removed before the predicate failed stay removed and counted
+    if(ret < 0)
+    {
+        l->error = ret;
+        return removed;
+    }
+    
+    RET(removed, l);
 }
 
-void list_clear_custom(alg_foldfun fun, void *state, struct list *l)
+void list_splice(int pos, struct list *src, struct list *l)
 {
-    struct list_elem *current, *next;
-    int pos;
-    
     if(!l)
         RETV(ALG_ERROR_BAD_STRUCTURE, l);
     
-    next = l->first;
-    pos = 0;
-    while(next)
+    if(!src || src == l)
+        RETV(ALG_ERROR_BAD_SOURCE, l);
+    
+    if(pos < 0 || pos > l->size)
+        RETV(ALG_ERROR_INDEX_RANGE, l);
+    
+    list_intern_share(src, l);
+    CATCHV(l);
+    
+    if(!src->size)
     {
-        current = next;
-        next = current->next;
-        if(fun)
-            fun(pos, current->elem, state);
-        free(current);
-        pos++;
+        list_intern_decouple(src);
+        RETV(ALG_SUCCESS, l);
     }
-    l->first = 0;
-    l->last = 0;
-    l->current = 0;
-    l->size = 0;
+    
+    list_intern_link(pos, src->first, src->last, src->size, l);
+    
+    src->first = 0;
+    src->last = 0;
+    src->current = 0;
+    src->finger = 0;
+    src->size = 0;
+    list_intern_decouple(src);
+    
     l->error = ALG_SUCCESS;
 }
 
+void list_split_at(int pos, struct list *dst, struct list *l)
+{
+    struct list_elem *elem, *last;
+    int count;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!dst || dst == l)
+        RETV(ALG_ERROR_BAD_DESTINATION, l);
+    
+    if(pos < 0 || pos > l->size)
+        RETV(ALG_ERROR_INDEX_RANGE, l);
+    
+    if(pos == l->size)
+        RETV(ALG_SUCCESS, l);
+    
+    list_intern_share(dst, l);
+    CATCHV(l);
+    
+    elem = list_intern_get(pos, l);
+    last = l->last;
+    count = l->size-pos;
+    
+    l->last = elem->prev;
+    if(elem->prev)
+        elem->prev->next = 0;
+    else
+        l->first = 0;
+    l->size = pos;
+    
+    // the finger was left at pos by the lookup, current may have moved on
+    l->finger = l->last;
+    l->fingerpos = pos-1;
+    l->current = 0;
+    
+    list_intern_link(dst->size, elem, last, count, dst);
+    list_intern_decouple(l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void list_move_node(int from, struct list *src, int to, struct list *l)
+{
+    struct list_elem *elem;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!src)
+        RETV(ALG_ERROR_BAD_SOURCE, l);
+    
+    // to is the position in l once the node has left src
+    if(from < 0 || from >= src->size || to < 0 || to > l->size-(src == l))
+        RETV(ALG_ERROR_INDEX_RANGE, l);
+    
+    if(src != l)
+    {
+        list_intern_share(src, l);
+        CATCHV(l);
+    }
+    
+    elem = list_intern_get(from, src);
+    if(elem == src->current)
+        src->current = 0;
+    list_intern_unlink(elem, src);
+    
+    list_intern_link(to, elem, elem, 1, l);
+    list_intern_decouple(src);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void list_sort(alg_cmpfun cmp, struct list *l)
+{
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, l);
+    
+    list_intern_relink(list_intern_msort(l->first, cmp), l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void list_sort_par(alg_cmpfun cmp, int threads, struct list *l)
+{
+    struct list_sort_state s[ALG_THREAD_MAX];
+    struct list_elem *elem, *next;
+    int i, k, chunk, count, merges;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, l);
+    
+    if(l->size < ALG_LIST_SORT_PAR)
+    {
+        list_sort(cmp, l);
+        return;
+    }
+    
+    // cut the list into one chain per thread, then merge neighbours pairwise
+    count = alg_thread_count(threads);
+    chunk = (l->size+count-1)/count;
+    
+    for(i=0, elem=l->first; elem; i++)
+    {
+        s[i].a = elem;
+        s[i].cmp = cmp;
+        for(k=1; k<chunk && elem->next; k++)
+            elem = elem->next;
+        next = elem->next;
+        elem->next = 0;
+        elem = next;
+    }
+    count = i;
+    alg_thread_run(count, list_intern_msort_par, s, sizeof(struct list_sort_state));
+    
+    while(count > 1)
+    {
+        merges = (count+1)/2;
+        for(i=0; i<merges; i++)
+        {
+            s[i].a = s[2*i].a;
+            s[i].b = 2*i+1 < count ? s[2*i+1].a : 0;
+        }
+        alg_thread_run(merges, list_intern_merge_par, s, sizeof(struct list_sort_state));
+        count = merges;
+    }
+    
+    list_intern_relink(s[0].a, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void list_merge(alg_cmpfun cmp, struct list *src, struct list *l)
+{
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!src || src == l || !cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, l);
+    
+    list_intern_share(src, l);
+    CATCHV(l);
+    
+    if(!src->size)
+    {
+        list_intern_decouple(src);
+        RETV(ALG_SUCCESS, l);
+    }
+    
+    list_intern_relink(list_intern_merge(l->first, src->first, cmp), l);
+    l->size += src->size;
+    
+    src->first = 0;
+    src->last = 0;
+    src->current = 0;
+    src->finger = 0;
+    src->size = 0;
+    list_intern_decouple(src);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void list_fold(alg_foldfun fun, void *state, struct list *l)
+{
+    struct list_fold_state fstate;
+    fstate.fun = fun;
+    fstate.state = state;
+    list_intern_iterate(list_intern_fold, &fstate, l);
+    if(l->error == ALG_ERROR_NOT_FOUND)
+        l->error = ALG_SUCCESS;
+}
+
+void list_clear(struct list *l)
+{
+    list_clear_custom(0, 0, l);
+}
+
+void list_clear_custom(alg_foldfun fun, void *state, struct list *l)
+{
+    struct list_elem *current;
+    int pos;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(fun)
+        for(current=l->first, pos=0; current; current=current->next, pos++)
+            fun(pos, current->elem, state);
+    
+    // nodes live in the slabs, so there is nothing to free one by one
+    list_intern_release(l);
+    l->first = 0;
+    l->last = 0;
+    l->current = 0;
+    l->finger = 0;
+    l->size = 0;
+    list_intern_decouple(l);
+    l->error = ALG_SUCCESS;
+}
+
+int list_write_fd(int fd, struct list *l)
+{
+    char head[ALG_IO_HEAD] __attribute__((aligned(8)));
+    struct iovec iov[ALG_IO_BATCH];
+    struct list_elem *elem;
+    int n, ret;
+    
+    if(!l)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    alg_io_head_init(l->size, l->esize, head);
+    iov[0].iov_base = head;
+    iov[0].iov_len = ALG_IO_HEAD;
+    n = 1;
+    
+    // every node is a buffer of its own, a batch goes out per writev
+    for(elem=l->first; elem; elem=elem->next)
+    {
+        iov[n].iov_base = elem->elem;
+        iov[n].iov_len = l->esize;
+        if(++n == ALG_IO_BATCH)
+        {
+            if((ret = alg_io_writev(fd, iov, n)) != ALG_SUCCESS)
+                RETE(ret, l);
+            n = 0;
+        }
+    }
+    
+    ret = alg_io_writev(fd, iov, n);
+    RETE(ret, l);
+}
+
+int list_read_fd(int fd, struct list *l)
+{
+    struct iovec iov[ALG_IO_BATCH];
+    struct list_elem *nodes[ALG_IO_BATCH];
+    long left;
+    int i, n, ret;
+    
+    if(!l)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if((left = alg_io_head_read(fd, l->esize)) < 0)
+        RETE(left, l);
+    
+    // the count comes from the stream, bound it like vector_read_fd does
+    if(left > INT_MAX/list_intern_nodesize(l))
+        RETE(ALG_ERROR_BAD_SIZE, l);
+    
+    list_clear(l);
+    
+    // a batch of nodes is allocated and read into with one readv
+    for(; left; left-=n)
+    {
+        n = left < ALG_IO_BATCH ? left : ALG_IO_BATCH;
+        
+        for(i=0; i<n; i++)
+        {
+            if(!(nodes[i] = list_intern_alloc(l)))
+            {
+                while(i--)
+                    list_intern_free(nodes[i], l);
+                return l->error;
+            }
+            iov[i].iov_base = nodes[i]->elem;
+            iov[i].iov_len = l->esize;
+        }
+        
+        if((ret = alg_io_readv(fd, iov, n)) != ALG_SUCCESS)
+        {
+            for(i=0; i<n; i++)
+                list_intern_free(nodes[i], l);
+            RETE(ret, l);
+        }
+        
+        for(i=0; i<n; i++)
+            list_intern_append(nodes[i], l);
+    }
+    
+    RETE(ALG_SUCCESS, l);
+}
+
+int list_stats(struct alg_stats *dst, struct list *l)
+{
+    if(!l)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!dst)
+        RETE(ALG_ERROR_BAD_DESTINATION, l);
+
+#ifdef ALG_STATS
+    memcpy(dst, &l->stats, sizeof(struct alg_stats));
+    RETE(ALG_SUCCESS, l);
+#else
+    RETE(ALG_ERROR_UNSET, l);
+#endif
+}
+
 #ifdef ALG_TEST
 
+#include "iter.h"
 #include <stdio.h>
+#include <time.h>
 
 void show_list(struct list *l)
 {
@@ -665,7 +1519,7 @@ void show_list(struct list *l)
     struct list_elem *lelem;
     
     printf("size: %i | ", l->size);
-
+    
     if(l->first)
         printf("first: %i | ", *(int*) l->first->elem);
     else
@@ -725,6 +1579,431 @@ int test_fun2(int pos, void *elem, void *state)
     return 0;
 }
 
+int test_finger()
+{
+    struct list *l = 0;
+    long sum = 0;
+    int i;
+    clock_t start;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<100000; i++)
+        list_push(&i, l);
+    
+    start = clock();
+    for(i=0; i<l->size; i++)
+        sum += *(int*)list_at(i, l);
+    printf("indexed loop: sum %li | %.2f ms\n", sum, (clock()-start)*1000.0/CLOCKS_PER_SEC);
+    
+    // drop every other element walking forward, the finger follows
+    for(i=0; i<l->size; i++)
+        list_del(i, l);
+    for(i=0, sum=0; i<l->size; i++)
+        sum += *(int*)list_at(i, l);
+    if(catch(l))
+        return 1;
+    printf("after deleting evens: size %i | sum %li\n", l->size, sum);
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+int test_stats()
+{
+    struct list *l = 0;
+    struct alg_stats stats;
+    int i;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<100; i++)
+        list_push(&i, l);
+    list_at(50, l);
+    list_at(10, l);
+    list_find(test_fun, &i, l);
+    list_clear(l);
+    
+    if(list_stats(&stats, l) == ALG_ERROR_UNSET)
+        printf("stats: %s\n", alg_str_error(l->error));
+    else
+        printf("stats: hops %lu | allocs %lu | frees %lu\n", stats.hops, stats.allocs, stats.frees);
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+int test_unchecked()
+{
+    struct list *l = 0;
+    int i, *p, sum = 0;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<10; i++)
+        list_push(&i, l);
+    
+    for(p=list_first_unchecked(l); p; p=list_next_unchecked(p))
+        sum += *p;
+    printf("unchecked: size %i | sum %i | backwards:", list_size_unchecked(l), sum);
+    for(p=list_last_unchecked(l); p; p=list_prev_unchecked(p))
+        printf(" %i", *p);
+    printf("\n");
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+int test_emplace()
+{
+    struct list *l = 0;
+    int i, *ptr;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<5; i++)
+    {
+        ptr = list_emplace(l);
+        if(catch(l))
+            return 1;
+        *ptr = i*10;
+    }
+    
+    printf("emplace:");
+    for(ptr=list_first_unchecked(l); ptr; ptr=list_next_unchecked(ptr))
+        printf(" %i", *ptr);
+    printf(" | size %i\n", l->size);
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+void show_ints(char *name, struct list *l)
+{
+    int *ptr;
+    
+    printf("%s:", name);
+    for(ptr=list_first_unchecked(l); ptr; ptr=list_next_unchecked(ptr))
+        printf(" %i", *ptr);
+    printf(" | size %i\n", l->size);
+}
+
+int test_splice()
+{
+    struct list *a = 0, *b = 0, *c = 0;
+    int i;
+    
+    if(list_init(sizeof(int), &a) != ALG_SUCCESS
+        || list_init(sizeof(int), &b) != ALG_SUCCESS
+        || list_init(sizeof(char), &c) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<5; i++)
+    {
+        list_push(&i, a);
+        *(int*)list_emplace(b) = 10+i;
+    }
+    
+    list_splice(2, b, a);
+    if(catch(a))
+        return 1;
+    show_ints("splice a", a);
+    show_ints("splice b", b);
+    printf("emptied b uncoupled: %s\n", b->pool ? "no" : "yes");
+    
+    list_split_at(3, b, a);
+    if(catch(a))
+        return 1;
+    show_ints("split a", a);
+    show_ints("split b", b);
+    
+    list_move_node(0, b, 0, a);
+    list_move_node(0, a, 3, a);
+    list_move_node(b->size-1, b, a->size, a);
+    if(catch(a))
+        return 1;
+    show_ints("move a", a);
+    show_ints("move b", b);
+    
+    // lists holding each others nodes allocate from the merged pool until
+    // one of them runs empty
+    printf("shared pool: %s\n", a->pool == b->pool ? "yes" : "no");
+    list_clear(b);
+    for(i=0; i<40; i++)
+        list_push(&i, b);
+    printf("shared after clear: %s\n", a->pool == b->pool ? "yes" : "no");
+    
+    list_splice(0, c, a);
+    catch(a);
+    list_split_at(a->size+1, b, a);
+    catch(a);
+    
+    return list_finish(a) != ALG_SUCCESS || list_finish(b) != ALG_SUCCESS
+        || list_finish(c) != ALG_SUCCESS;
+}
+
+struct test_stage
+{
+    struct list *l;
+    long sum;
+};
+
+// allocates and frees through the pool it shares with the other stage
+void* test_stage_run(void *arg)
+{
+    struct test_stage *s = arg;
+    int i, k, j;
+    
+    for(i=0; i<2000; i++)
+    {
+        for(k=0; k<50; k++)
+            list_push(&k, s->l);
+        for(k=0; k<50; k++)
+        {
+            list_pop(&j, s->l);
+            s->sum += j;
+        }
+    }
+    
+    return 0;
+}
+
+int test_split_threads()
+{
+    struct test_stage stages[2] = {{0, 0}, {0, 0}};
+    int i;
+    
+    if(list_init(sizeof(int), &stages[0].l) != ALG_SUCCESS
+        || list_init(sizeof(int), &stages[1].l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        list_push(&i, stages[0].l);
+    list_split_at(500, stages[1].l, stages[0].l);
+    if(catch(stages[0].l))
+        return 1;
+    
+    // both halves go on in their own thread, the pool stays shared
+    alg_thread_run(2, test_stage_run, stages, sizeof(struct test_stage));
+    printf("split threads: sums %li %li | sizes %i %i\n", stages[0].sum, stages[1].sum,
+        stages[0].l->size, stages[1].l->size);
+    
+    return stages[0].sum != stages[1].sum || stages[0].sum != 2000*1225L
+        || list_finish(stages[0].l) != ALG_SUCCESS || list_finish(stages[1].l) != ALG_SUCCESS;
+}
+
+struct test_point
+{
+    int x, y;
+};
+
+ALG_LIST_DEFINE(struct test_point, plist)
+
+int test_typed()
+{
+    struct list *l = 0;
+    struct test_point p, *ptr;
+    int i;
+    
+    if(plist_init(&l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<5; i++)
+    {
+        p.x = i;
+        p.y = i*i;
+        plist_push(p, l);
+    }
+    
+    printf("typed:");
+    for(ptr=plist_first(l); ptr; ptr=plist_next(ptr))
+        printf(" (%i, %i)", ptr->x, ptr->y);
+    p = plist_pop(l);
+    printf(" | popped (%i, %i) | size %i\n", p.x, p.y, plist_size(l));
+    
+    plist_ins(1, p, l);
+    plist_del(0, l);
+    p = plist_rem(0, l);
+    if(l->error != ALG_SUCCESS || p.x != 4 || plist_size(l) != 3 || plist_first(l)->x != 1)
+        return 1;
+    plist_clear(l);
+    
+    return plist_finish(l) != ALG_SUCCESS;
+}
+
+int test_odd(int pos, void *elem, void *state)
+{
+    return *(int*)elem % 2;
+}
+
+int test_remove_if()
+{
+    struct list *l = 0;
+    int i, removed;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<10; i++)
+        list_push(&i, l);
+    list_at(7, l);
+    
+    removed = list_remove_if(test_odd, 0, l);
+    if(catch(l))
+        return 1;
+    printf("remove_if: %i | ", removed);
+    show_ints("left", l);
+    printf("last: %i | at 3: %i\n", *(int*)list_last(l), *(int*)list_at(3, l));
+    
+    for(i=1; i<6; i+=2)
+        list_push(&i, l);
+    removed = list_remove_if(test_odd, 0, l);
+    printf("reused: %i | size %i\n", removed, l->size);
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+int iter_count_n(void **elems, int count, void *state)
+{
+    *(int*)state += count;
+    return 0;
+}
+
+int test_iter()
+{
+    struct list *l = 0;
+    struct alg_iter it;
+    int i, count, folded = 0;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        list_push(&i, l);
+    
+    alg_iter_list(l, &it);
+    alg_iter_filter(test_odd, 0, &it);
+    alg_iter_take(300, &it);
+    count = alg_iter_fold_n(iter_count_n, &folded, &it);
+    printf("iter: %i folded | %i counted\n", count, folded);
+    
+    return list_finish(l) != ALG_SUCCESS;
+}
+
+int test_fd()
+{
+    struct list *l = 0, *r = 0;
+    int i, fd[2], *a, *b, same;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS
+        || list_init(sizeof(int), &r) != ALG_SUCCESS || pipe(fd))
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        list_push(&i, l);
+    *(int*)list_emplace(r) = -1;
+    
+    if(list_write_fd(fd[1], l) != ALG_SUCCESS || list_read_fd(fd[0], r) != ALG_SUCCESS)
+    {
+        catch(l);
+        catch(r);
+        return 1;
+    }
+    
+    same = l->size == r->size;
+    for(a=list_first_unchecked(l), b=list_first_unchecked(r); a && b; a=list_next_unchecked(a), b=list_next_unchecked(b))
+        same = same && *a == *b;
+    printf("fd: %i read | %s\n", r->size, same ? "same" : "different");
+    
+    // a stream cut short is refused
+    list_write_fd(fd[1], l);
+    close(fd[1]);
+    read(fd[0], &i, sizeof(int));
+    list_read_fd(fd[0], r);
+    catch(r);
+    close(fd[0]);
+    
+    return list_finish(l) != ALG_SUCCESS || list_finish(r) != ALG_SUCCESS;
+}
+
+struct sort_pair
+{
+    int key, seq;
+};
+
+int cmp_pair(void *a, void *b)
+{
+    return ((struct sort_pair*)a)->key - ((struct sort_pair*)b)->key;
+}
+
+int cmp_int(void *a, void *b)
+{
+    return *(int*)a < *(int*)b ? -1 : *(int*)a > *(int*)b;
+}
+
+int test_sort()
+{
+    struct list *l = 0, *m = 0;
+    struct sort_pair pair, *p;
+    struct list_elem *elem;
+    int i, *ptr, prev, ok, count;
+    
+    if(list_init(sizeof(struct sort_pair), &l) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<10; i++)
+    {
+        pair.key = (i*7)%4;
+        pair.seq = i;
+        list_push(&pair, l);
+    }
+    
+    list_sort(cmp_pair, l);
+    if(catch(l))
+        return 1;
+    printf("sort:");
+    for(p=list_first_unchecked(l); p; p=list_next_unchecked(p))
+        printf(" %i/%i", p->key, p->seq);
+    printf("\n");
+    list_finish(l);
+    l = 0;
+    
+    if(list_init(sizeof(int), &l) != ALG_SUCCESS
+        || list_init(sizeof(int), &m) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<5; i++)
+    {
+        *(int*)list_emplace(l) = i*2;
+        *(int*)list_emplace(m) = i*3;
+    }
+    list_merge(cmp_int, m, l);
+    if(catch(l))
+        return 1;
+    show_ints("merge", l);
+    list_clear(l);
+    
+    srand(42);
+    count = ALG_LIST_SORT_PAR*2+3;
+    for(i=0; i<count; i++)
+        *(int*)list_emplace(l) = rand()%1000;
+    
+    list_sort_par(cmp_int, 3, l);
+    if(catch(l))
+        return 1;
+    
+    ok = l->size == count && !l->first->prev;
+    for(prev=-1, elem=l->first, i=0; elem; elem=elem->next, i++)
+    {
+        ptr = (int*)elem->elem;
+        ok = ok && prev <= *ptr && (!elem->next || elem->next->prev == elem);
+        prev = *ptr;
+    }
+    ok = ok && i == count && elem == 0;
+    printf("sort par: %s\n", ok ? "sorted" : "unsorted");
+    
+    return list_finish(l) != ALG_SUCCESS || list_finish(m) != ALG_SUCCESS;
+}
+
 int main(int argc, char *argv[])
 {
     struct list *l = 0;
@@ -851,10 +2130,25 @@ int main(int argc, char *argv[])
         return 1;
     show_list(l);
     
+    for(i=0; i<100; i++)
+        list_push(&i, l);
+    elem = list_last(l);
+    list_pop(0, l);
+    printf("node reused: %s\n", list_push(&i, l) == elem ? "yes" : "no");
+    if(catch(l))
+        return 1;
+    
+    list_clear(l);
+    if(catch(l))
+        return 1;
+    printf("slabs after clear: %s\n", l->pool->slabs && !l->pool->slabs->next ? "one" : "other");
+    
     if(list_finish(l) != ALG_SUCCESS)
         return 1;
     
-    return 0;
+    return test_finger() || test_stats() || test_unchecked() || test_typed() || test_emplace()
+        || test_splice() || test_split_threads() || test_sort() || test_remove_if()
+        || test_iter() || test_fd();
 }
 
 #endif
@@ -24,21 +24,52 @@
 #define __ALG_LIST_H__
 
 #include "fun.h"
+#include "alloc.h"
+#include "stats.h"
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#define ALG_LIST_SLAB       16      // nodes in the first slab
+#define ALG_LIST_SLAB_MAX   4096    // nodes in later slabs, doubling up to this
+#define ALG_LIST_SORT_PAR   65536   // size below which list_sort_par stays single threaded
 
 struct list_elem
 {
     struct list_elem *next, *prev;
-    void *elem;
+    char elem[];
+};
+
+struct list_slab
+{
+    struct list_slab *next;
+    int count, used;
+    char mem[] __attribute__((aligned(16)));
+};
+
+// slabs and recycled nodes, lists that exchanged nodes share one pool which
+// is locked as long as more than one list uses it
+struct list_pool
+{
+    struct list_pool *_Atomic parent;   // pool this one was merged into
+    struct list_slab *slabs, *oldest;
+    struct list_elem *free, *lastfree;
+    pthread_mutex_t lock;
+    _Atomic int refs;                   // lists and merged pools using this one
 };
 
 struct list
 {
-    struct list_elem *first, *last, *current;
-    int size, esize, error;
+    struct list_elem *first, *last, *current, *finger;
+    struct list_pool *pool;
+    struct alg_allocator *alloc;
+    int size, esize, error, fingerpos;
     char status;
+    struct alg_stats stats;
 };
 
 int list_init(int elemsize, struct list **l);
+int list_init_alloc(int elemsize, struct alg_allocator *alloc, struct list **l);
 int list_finish(struct list* l);
 int list_finish_custom(alg_foldfun *fun, void *state, struct list *l);
 
@@ -59,6 +90,7 @@ int   list_size(struct list *l);
 
 void* list_push(void *elem, struct list *l);
 void* list_push_c(void *elem, struct list *l);
+void* list_emplace(struct list *l);
 void* list_ins(int pos, void *elem, struct list* l);
 void* list_ins_c(int pos, void *elem, struct list* l);
 void* list_ins_after(alg_foldfun fun, void *state, void *elem, struct list *l);
@@ -78,11 +110,140 @@ void list_find_del(alg_foldfun fun, void *state, struct list *l);
 void list_find_del_custom(alg_foldfun ffun, void *state, alg_mapfun dfun, struct list *l);
 void list_find_rem(alg_foldfun fun, void *state, void *dst, struct list *l);
 void list_find_rem_custom(alg_foldfun ffun, void *state, void *dst, alg_mapfun dfun, struct list *l);
+// drops every element the predicate returns a positive value for in one
+// traversal and returns how many went, a negative value stops with that error
+// in l->error, the elements removed before it are still counted
+int  list_remove_if(alg_foldfun fun, void *state, struct list *l);
+
+// Nodes are relinked instead of copied, only the lookup of pos walks the
+// list. Both lists have to agree on element size and allocator and share
+// their node pool until one of them runs empty again. A shared pool is
+// locked, so the lists can go on to different threads afterwards.
+void list_splice(int pos, struct list *src, struct list *l);
+void list_split_at(int pos, struct list *dst, struct list *l);
+void list_move_node(int from, struct list *src, int to, struct list *l);
+
+// Stable merge sorts relinking the nodes, nothing is allocated or copied.
+// list_merge takes all nodes of the sorted src into the sorted l.
+void list_sort(alg_cmpfun cmp, struct list *l);
+void list_sort_par(alg_cmpfun cmp, int threads, struct list *l);
+void list_merge(alg_cmpfun cmp, struct list *src, struct list *l);
 
 void list_fold(alg_foldfun fun, void *state, struct list *l);
 
 void list_clear(struct list *l);
 void list_clear_custom(alg_foldfun fun, void *state, struct list *l);
 
+// Same format as vector_write_fd, nodes are passed to readv and writev in
+// batches without an intermediate copy. Reading replaces the contents.
+int list_write_fd(int fd, struct list *l);
+int list_read_fd(int fd, struct list *l);
+
+int list_stats(struct alg_stats *dst, struct list *l);
+
+// Inline accessors without any checks and without touching the error field.
+// They walk payload pointers, so a list is iterated with
+// for(p=list_first_unchecked(l); p; p=list_next_unchecked(p)).
+
+#define ALG_LIST_NODE(elem) ((struct list_elem*)((char*)(elem)-offsetof(struct list_elem, elem)))
+
+static inline void* list_first_unchecked(struct list *l)
+{
+    return l->first ? l->first->elem : 0;
+}
+
+static inline void* list_last_unchecked(struct list *l)
+{
+    return l->last ? l->last->elem : 0;
+}
+
+static inline void* list_next_unchecked(void *elem)
+{
+    struct list_elem *next = ALG_LIST_NODE(elem)->next;
+    return next ? next->elem : 0;
+}
+
+static inline void* list_prev_unchecked(void *elem)
+{
+    struct list_elem *prev = ALG_LIST_NODE(elem)->prev;
+    return prev ? prev->elem : 0;
+}
+
+static inline int list_size_unchecked(struct list *l)
+{
+    return l->size;
+}
+
+// Typed wrappers over a struct list of T, ALG_LIST_DEFINE(struct foo, foolist)
+// emits foolist_init, foolist_push and so on. first, last, next and prev
+// return null at the ends, pop expects a non empty list and rem a valid
+// position. Functions taking callbacks have no typed wrapper, they are
+// called on the list directly.
+
+#define ALG_LIST_DEFINE(T, name) \
+static inline int name##_init(struct list **l) \
+{ \
+    return list_init(sizeof(T), l); \
+} \
+static inline int name##_finish(struct list *l) \
+{ \
+    return list_finish(l); \
+} \
+static inline int name##_size(struct list *l) \
+{ \
+    return l->size; \
+} \
+static inline T* name##_first(struct list *l) \
+{ \
+    return (T*)list_first_unchecked(l); \
+} \
+static inline T* name##_last(struct list *l) \
+{ \
+    return (T*)list_last_unchecked(l); \
+} \
+static inline T* name##_next(T *elem) \
+{ \
+    return (T*)list_next_unchecked(elem); \
+} \
+static inline T* name##_prev(T *elem) \
+{ \
+    return (T*)list_prev_unchecked(elem); \
+} \
+static inline T* name##_at(int pos, struct list *l) \
+{ \
+    return (T*)list_at(pos, l); \
+} \
+static inline T* name##_push(T elem, struct list *l) \
+{ \
+    T *ptr = (T*)list_emplace(l); \
+    if(ptr) \
+        *ptr = elem; \
+    return ptr; \
+} \
+static inline T name##_pop(struct list *l) \
+{ \
+    T elem = *(T*)l->last->elem; \
+    list_pop(0, l); \
+    return elem; \
+} \
+static inline T* name##_ins(int pos, T elem, struct list *l) \
+{ \
+    return (T*)list_ins(pos, &elem, l); \
+} \
+static inline void name##_del(int pos, struct list *l) \
+{ \
+    list_del(pos, l); \
+} \
+static inline T name##_rem(int pos, struct list *l) \
+{ \
+    T elem; \
+    list_rem(pos, &elem, l); \
+    return elem; \
+} \
+static inline void name##_clear(struct list *l) \
+{ \
+    list_clear(l); \
+}
+
 #endif
 
@@ -0,0 +1,601 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "queue.h"
+#include "error.h"
+#include "help.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+
+#define SEQ(q, pos)     ((_Atomic size_t*)((q)->slots+((pos) & (q)->mask)*(q)->stride))
+#define SLOT(q, pos)    ((q)->slots+((pos) & (q)->mask)*(q)->stride+sizeof(size_t))
+
+#define REF(tag, idx)   ((uint64_t)(tag) << 32 | (uint32_t)(idx))
+#define REF_TAG(ref)    ((uint32_t)((ref) >> 32))
+#define REF_IDX(ref)    ((uint32_t)(ref))
+
+struct lqueue_node
+{
+    _Atomic uint64_t next;
+    _Atomic uint32_t busy;  // payload not copied out yet
+    char elem[];
+};
+
+// claims up to count consecutive slots from *pos on whose sequence number
+// is pos+offset, offset is 0 for free slots and 1 for filled ones
+int queue_intern_claim(_Atomic size_t *end, size_t offset, int count, size_t *pos, struct queue *q)
+{
+    intptr_t diff;
+    int n;
+    
+    *pos = atomic_load_explicit(end, memory_order_relaxed);
+    while(1)
+    {
+        for(n=0; n<count; n++)
+            if(atomic_load_explicit(SEQ(q, *pos+n), memory_order_acquire) != *pos+n+offset)
+                break;
+        
+        if(n)
+        {
+            if(atomic_compare_exchange_weak_explicit(end, pos, *pos+n, memory_order_relaxed, memory_order_relaxed))
+                return n;
+            continue;
+        }
+        
+        // a slot one lap behind means full or empty, ahead means we are stale
+        diff = (intptr_t)atomic_load_explicit(SEQ(q, *pos), memory_order_acquire) - (intptr_t)(*pos+offset);
+        if(diff < 0)
+            return 0;
+        *pos = atomic_load_explicit(end, memory_order_relaxed);
+    }
+}
+
+int queue_init(int elemsize, int capacity, struct queue **pq)
+{
+    int malloced = 0;
+    struct queue *q;
+    size_t i, size;
+    
+    if(elemsize <= 0 || capacity <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pq)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pq)
+    {
+        malloced = 1;
+        *pq = aligned_alloc(ALG_CACHE_LINE, sizeof(struct queue));
+        if(!*pq)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    q = *pq;
+    for(size=1; size<capacity; size*=2);
+    
+    q->esize = elemsize;
+    q->capacity = size;
+    q->mask = size-1;
+    q->stride = (sizeof(size_t)+elemsize+sizeof(size_t)-1) & ~(sizeof(size_t)-1);
+    q->status = ALG_STATUS_MALLOCED*malloced;
+    q->slots = malloc(size*q->stride);
+    
+    if(!q->slots)
+    {
+        if(malloced)
+            free(q);
+        return ALG_ERROR_NO_MEMORY;
+    }
+    
+    for(i=0; i<size; i++)
+        atomic_init(SEQ(q, i), i);
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+    
+    q->error = ALG_SUCCESS;
+    return ALG_SUCCESS;
+}
+
+int queue_finish(struct queue *q)
+{
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    free(q->slots);
+    if(q->status & ALG_STATUS_MALLOCED)
+        free(q);
+    else
+        memset(q, 0, sizeof(struct queue));
+    
+    return ALG_SUCCESS;
+}
+
+int queue_push(void *elem, struct queue *q)
+{
+    return queue_push_n(elem, 1, q) == 1 ? ALG_SUCCESS : ALG_ERROR_FULL;
+}
+
+int queue_push_n(void *elems, int count, struct queue *q)
+{
+    size_t pos;
+    int i, n;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!elems)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if(count <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    n = queue_intern_claim(&q->tail, 0, count, &pos, q);
+    
+    for(i=0; i<n; i++)
+    {
+        memcpy(SLOT(q, pos+i), elems+i*q->esize, q->esize);
+        atomic_store_explicit(SEQ(q, pos+i), pos+i+1, memory_order_release);
+    }
+    
+    return n;
+}
+
+int queue_pop(void *dst, struct queue *q)
+{
+    return queue_pop_n(dst, 1, q) == 1 ? ALG_SUCCESS : ALG_ERROR_EMPTY;
+}
+
+int queue_pop_n(void *dst, int count, struct queue *q)
+{
+    size_t pos;
+    int i, n;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!dst)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(count <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    n = queue_intern_claim(&q->head, 1, count, &pos, q);
+    
+    for(i=0; i<n; i++)
+    {
+        memcpy(dst+i*q->esize, SLOT(q, pos+i), q->esize);
+        atomic_store_explicit(SEQ(q, pos+i), pos+i+q->mask+1, memory_order_release);
+    }
+    
+    return n;
+}
+
+int queue_size(struct queue *q)
+{
+    size_t head, tail;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    // only a snapshot while other threads are active
+    head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    
+    return tail > head ? tail-head : 0;
+}
+
+// chunk k holds ALG_LQUEUE_CHUNK<<k nodes, refs count nodes from 1
+struct lqueue_node* lqueue_intern_node(uint32_t ref, struct lqueue *q)
+{
+    uint32_t idx = ref-1, k = 31-__builtin_clz(idx/ALG_LQUEUE_CHUNK+1);
+    char *chunk = atomic_load_explicit(&q->chunks[k], memory_order_acquire);
+    
+    return (struct lqueue_node*)(chunk+(idx-ALG_LQUEUE_CHUNK*((1u << k)-1))*q->stride);
+}
+
+void lqueue_intern_link(struct lqueue_node *node, uint32_t ref)
+{
+    uint64_t next = atomic_load_explicit(&node->next, memory_order_relaxed);
+    atomic_store_explicit(&node->next, REF(REF_TAG(next)+1, ref), memory_order_relaxed);
+}
+
+uint32_t lqueue_intern_alloc(struct lqueue *q)
+{
+    struct lqueue_node *node;
+    uint64_t top, next;
+    uint32_t idx, k;
+    char *chunk, *expected;
+    
+    // recycled nodes first, the tag keeps a stale top from matching
+    top = atomic_load_explicit(&q->free, memory_order_acquire);
+    while(REF_IDX(top))
+    {
+        node = lqueue_intern_node(REF_IDX(top), q);
+        next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        if(atomic_compare_exchange_weak_explicit(&q->free, &top, REF(REF_TAG(top)+1, REF_IDX(next)),
+            memory_order_acquire, memory_order_acquire))
+            return REF_IDX(top);
+    }
+    
+    idx = atomic_fetch_add_explicit(&q->fresh, 1, memory_order_relaxed);
+    k = 31-__builtin_clz(idx/ALG_LQUEUE_CHUNK+1);
+    if(k >= ALG_LQUEUE_CHUNKS)
+        return 0;
+    
+    if(!atomic_load_explicit(&q->chunks[k], memory_order_acquire))
+    {
+        chunk = calloc(ALG_LQUEUE_CHUNK << k, q->stride);
+        if(!chunk)
+            return 0;
+        expected = 0;
+        if(!atomic_compare_exchange_strong_explicit(&q->chunks[k], &expected, chunk,
+            memory_order_acq_rel, memory_order_acquire))
+            free(chunk);
+    }
+    
+    return idx+1;
+}
+
+void lqueue_intern_free(uint32_t ref, struct lqueue *q)
+{
+    struct lqueue_node *node = lqueue_intern_node(ref, q);
+    uint64_t top;
+    
+    // the consumer that claimed the node may still be copying its payload
+    while(atomic_load_explicit(&node->busy, memory_order_acquire))
+        sched_yield();
+    
+    top = atomic_load_explicit(&q->free, memory_order_relaxed);
+    
+    do
+        lqueue_intern_link(node, REF_IDX(top));
+    while(!atomic_compare_exchange_weak_explicit(&q->free, &top, REF(REF_TAG(top)+1, ref),
+        memory_order_release, memory_order_relaxed));
+}
+
+int lqueue_init(int elemsize, struct lqueue **pq)
+{
+    int i, malloced = 0;
+    struct lqueue *q;
+    uint32_t dummy;
+    
+    if(elemsize <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pq)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pq)
+    {
+        malloced = 1;
+        *pq = aligned_alloc(ALG_CACHE_LINE, sizeof(struct lqueue));
+        if(!*pq)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    q = *pq;
+    q->esize = elemsize;
+    q->stride = (sizeof(struct lqueue_node)+elemsize+sizeof(uint64_t)-1) & ~(sizeof(uint64_t)-1);
+    q->status = ALG_STATUS_MALLOCED*malloced;
+    atomic_init(&q->free, 0);
+    atomic_init(&q->fresh, 0);
+    for(i=0; i<ALG_LQUEUE_CHUNKS; i++)
+        atomic_init(&q->chunks[i], 0);
+    
+    // head always points to a dummy node in front of the first element
+    if(!(dummy = lqueue_intern_alloc(q)))
+    {
+        if(malloced)
+            free(q);
+        return ALG_ERROR_NO_MEMORY;
+    }
+    atomic_init(&q->head, REF(0, dummy));
+    atomic_init(&q->tail, REF(0, dummy));
+    
+    q->error = ALG_SUCCESS;
+    return ALG_SUCCESS;
+}
+
+int lqueue_finish(struct lqueue *q)
+{
+    int i;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    for(i=0; i<ALG_LQUEUE_CHUNKS; i++)
+        free(atomic_load(&q->chunks[i]));
+    
+    if(q->status & ALG_STATUS_MALLOCED)
+        free(q);
+    else
+        memset(q, 0, sizeof(struct lqueue));
+    
+    return ALG_SUCCESS;
+}
+
+int lqueue_push(void *elem, struct lqueue *q)
+{
+    int ret = lqueue_push_n(elem, 1, q);
+    return ret == 1 ? ALG_SUCCESS : ret;
+}
+
+int lqueue_push_n(void *elems, int count, struct lqueue *q)
+{
+    struct lqueue_node *node, *prev = 0;
+    uint32_t first = 0, last = 0, ref;
+    uint64_t tail, next;
+    int i;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!elems)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if(count <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    // build a private chain first, it is published with a single link
+    for(i=0; i<count; i++)
+    {
+        if(!(ref = lqueue_intern_alloc(q)))
+        {
+            if(!i)
+                return ALG_ERROR_NO_MEMORY;
+            break;
+        }
+        node = lqueue_intern_node(ref, q);
+        memcpy(node->elem, elems+i*q->esize, q->esize);
+        atomic_store_explicit(&node->busy, 1, memory_order_relaxed);
+        lqueue_intern_link(node, 0);
+        if(prev)
+            lqueue_intern_link(prev, ref);
+        else
+            first = ref;
+        prev = node;
+        last = ref;
+    }
+    count = i;
+    
+    while(1)
+    {
+        tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        node = lqueue_intern_node(REF_IDX(tail), q);
+        next = atomic_load_explicit(&node->next, memory_order_acquire);
+        
+        if(tail != atomic_load_explicit(&q->tail, memory_order_acquire))
+            continue;
+        
+        if(!REF_IDX(next))
+        {
+            if(atomic_compare_exchange_weak_explicit(&node->next, &next, REF(REF_TAG(next)+1, first),
+                memory_order_release, memory_order_relaxed))
+                break;
+        }
+        else
+            atomic_compare_exchange_weak_explicit(&q->tail, &tail, REF(REF_TAG(tail)+1, REF_IDX(next)),
+                memory_order_release, memory_order_relaxed);
+    }
+    
+    // move the tail to the end of the chain, lagging tails are helped along
+    atomic_compare_exchange_strong_explicit(&q->tail, &tail, REF(REF_TAG(tail)+1, last),
+        memory_order_release, memory_order_relaxed);
+    
+    return count;
+}
+
+int lqueue_pop(void *dst, struct lqueue *q)
+{
+    int ret = lqueue_pop_n(dst, 1, q);
+    return ret == 1 ? ALG_SUCCESS : ret ? ret : ALG_ERROR_EMPTY;
+}
+
+int lqueue_pop_n(void *dst, int count, struct lqueue *q)
+{
+    struct lqueue_node *node;
+    uint64_t head, tail, next;
+    int n;
+    
+    if(!q)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!dst)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(count <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    for(n=0; n<count; n++)
+    {
+        while(1)
+        {
+            head = atomic_load_explicit(&q->head, memory_order_acquire);
+            tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+            node = lqueue_intern_node(REF_IDX(head), q);
+            next = atomic_load_explicit(&node->next, memory_order_acquire);
+            
+            if(head != atomic_load_explicit(&q->head, memory_order_acquire))
+                continue;
+            
+            if(REF_IDX(head) == REF_IDX(tail))
+            {
+                if(!REF_IDX(next))
+                    return n;
+                atomic_compare_exchange_weak_explicit(&q->tail, &tail, REF(REF_TAG(tail)+1, REF_IDX(next)),
+                    memory_order_release, memory_order_relaxed);
+                continue;
+            }
+            
+            if(atomic_compare_exchange_weak_explicit(&q->head, &head, REF(REF_TAG(head)+1, REF_IDX(next)),
+                memory_order_acq_rel, memory_order_relaxed))
+                break;
+        }
+        
+        // the claimed node is the new dummy now, whoever frees it waits
+        // until its payload is copied out
+        node = lqueue_intern_node(REF_IDX(next), q);
+        memcpy(dst+n*q->esize, node->elem, q->esize);
+        atomic_store_explicit(&node->busy, 0, memory_order_release);
+        
+        // the old dummy is done, the popped node becomes the new one
+        lqueue_intern_free(REF_IDX(head), q);
+    }
+    
+    return n;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+#include <sched.h>
+
+#define TEST_THREADS    4
+#define TEST_ITEMS      50000
+
+struct test_state
+{
+    struct queue *q;
+    struct lqueue *lq;
+    int id;
+    long sum;
+};
+
+void* test_producer(void *arg)
+{
+    struct test_state *s = arg;
+    int i, batch[8];
+    
+    for(i=0; i<TEST_ITEMS; i++)
+    {
+        if(i%100 == 0 && i+8 <= TEST_ITEMS)
+        {
+            for(; i%100 < 8; i++)
+                batch[i%100] = i;
+            i--;
+            if(s->q)
+            {
+                int done = 0;
+                while((done += queue_push_n(batch+done, 8-done, s->q)) < 8)
+                    sched_yield();
+            }
+            else
+                lqueue_push_n(batch, 8, s->lq);
+            continue;
+        }
+        if(s->q)
+            while(queue_push(&i, s->q) != ALG_SUCCESS)
+                sched_yield();
+        else
+            lqueue_push(&i, s->lq);
+    }
+    return 0;
+}
+
+void* test_consumer(void *arg)
+{
+    struct test_state *s = arg;
+    int i, n, want, got = 0, batch[4];
+    
+    // every consumer takes exactly its share so none waits forever
+    while(got < TEST_ITEMS)
+    {
+        want = TEST_ITEMS-got < 4 ? TEST_ITEMS-got : 4;
+        n = s->q ? queue_pop_n(batch, want, s->q) : lqueue_pop_n(batch, want, s->lq);
+        if(!n)
+            sched_yield();
+        for(i=0; i<n; i++)
+            s->sum += batch[i];
+        got += n;
+    }
+    return 0;
+}
+
+int test_threads(struct queue *q, struct lqueue *lq)
+{
+    struct test_state s[2*TEST_THREADS];
+    pthread_t t[2*TEST_THREADS];
+    long sum = 0;
+    int i;
+    
+    for(i=0; i<2*TEST_THREADS; i++)
+    {
+        s[i].q = q;
+        s[i].lq = lq;
+        s[i].id = i;
+        s[i].sum = 0;
+        pthread_create(&t[i], 0, i < TEST_THREADS ? test_producer : test_consumer, &s[i]);
+    }
+    for(i=0; i<2*TEST_THREADS; i++)
+    {
+        pthread_join(t[i], 0);
+        sum += s[i].sum;
+    }
+    
+    printf("threaded: sum %li | expected %li\n", sum, (long)TEST_THREADS*TEST_ITEMS*(TEST_ITEMS-1)/2);
+    return sum != (long)TEST_THREADS*TEST_ITEMS*(TEST_ITEMS-1)/2;
+}
+
+int main(int argc, char *argv[])
+{
+    struct queue *q = 0;
+    struct lqueue *lq = 0;
+    int i, j, data[] = {1, 2, 3, 4, 5, 6};
+    
+    if(queue_init(sizeof(int), 5, &q) != ALG_SUCCESS)
+        return 1;
+    printf("capacity: %i\n", q->capacity);
+    
+    printf("push 6: %i pushed\n", queue_push_n(data, 6, q));
+    printf("push 6: %i pushed\n", queue_push_n(data, 6, q));
+    i = 9;
+    printf("push full: %s\n", alg_str_error(queue_push(&i, q)));
+    queue_pop(&j, q);
+    printf("pop: %i | size: %i\n", j, queue_size(q));
+    while(queue_pop(&j, q) == ALG_SUCCESS)
+        printf("%i ", j);
+    printf("\npop empty: %s\n", alg_str_error(queue_pop(&j, q)));
+    
+    if(queue_finish(q) != ALG_SUCCESS)
+        return 1;
+    
+    if(lqueue_init(sizeof(int), &lq) != ALG_SUCCESS)
+        return 1;
+    lqueue_push_n(data, 6, lq);
+    for(i=0; i<3; i++)
+        lqueue_push(&i, lq);
+    while(lqueue_pop(&j, lq) == ALG_SUCCESS)
+        printf("%i ", j);
+    printf("\nlinked pop empty: %s\n", alg_str_error(lqueue_pop(&j, lq)));
+    
+    q = 0;
+    if(queue_init(sizeof(int), 1024, &q) != ALG_SUCCESS)
+        return 1;
+    if(test_threads(q, 0) || test_threads(0, lq))
+        return 1;
+    
+    queue_finish(q);
+    return lqueue_finish(lq) != ALG_SUCCESS;
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_QUEUE_H__
+#define __ALG_QUEUE_H__
+
+#include "thread.h"
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define ALG_LQUEUE_CHUNK    64  // nodes in the first chunk, every further chunk doubles
+#define ALG_LQUEUE_CHUNKS   24
+
+// Both queues are safe for any number of producers and consumers. Results
+// are returned only, the error field is never written since it would be
+// shared between threads.
+
+// bounded ring of sequence numbered slots
+struct queue
+{
+    _Atomic size_t head __attribute__((aligned(ALG_CACHE_LINE)));
+    _Atomic size_t tail __attribute__((aligned(ALG_CACHE_LINE)));
+    char *slots __attribute__((aligned(ALG_CACHE_LINE)));
+    size_t mask;
+    int esize, stride, capacity, error;
+    char status;
+};
+
+// unbounded linked queue, nodes are recycled and never returned before
+// lqueue_finish, links are tagged indices so recycling is safe
+struct lqueue
+{
+    _Atomic uint64_t head __attribute__((aligned(ALG_CACHE_LINE)));
+    _Atomic uint64_t tail __attribute__((aligned(ALG_CACHE_LINE)));
+    _Atomic uint64_t free __attribute__((aligned(ALG_CACHE_LINE)));
+    _Atomic uint32_t fresh;
+    _Atomic(char*) chunks[ALG_LQUEUE_CHUNKS];
+    int esize, stride, error;
+    char status;
+};
+
+int queue_init(int elemsize, int capacity, struct queue **q);
+int queue_finish(struct queue *q);
+
+int queue_push(void *elem, struct queue *q);
+int queue_push_n(void *elems, int count, struct queue *q);
+int queue_pop(void *dst, struct queue *q);
+int queue_pop_n(void *dst, int count, struct queue *q);
+int queue_size(struct queue *q);
+
+int lqueue_init(int elemsize, struct lqueue **q);
+int lqueue_finish(struct lqueue *q);
+
+int lqueue_push(void *elem, struct lqueue *q);
+int lqueue_push_n(void *elems, int count, struct lqueue *q);
+int lqueue_pop(void *dst, struct lqueue *q);
+int lqueue_pop_n(void *dst, int count, struct lqueue *q);
+
+#endif
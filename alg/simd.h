@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_SIMD_H__
+#define __ALG_SIMD_H__
+
+#include <string.h>
+
+// Equality scan over records of esize bytes whose first keysize bytes are
+// compared against a key. A block of ALG_SIMD_WIDTH bytes is compared bytewise
+// against a pattern holding the key at every record start, bytes outside
+// the key are masked in and the mask is folded down to one bit per record.
+// Only power of two record sizes up to the block width qualify, everything
+// else is left to the caller's scalar loop.
+
+#define ALG_SIMD_WIDTH 64
+
+typedef int alg_simd_scanfun(const char *mem, int from, int count, int esize,
+    const char *pattern, unsigned long long care, int *dst, int max, int *next);
+
+static inline unsigned long long alg_simd_starts(int esize, int width)
+{
+    unsigned long long starts = 0;
+    int i;
+    
+    for(i=0; i<width; i+=esize)
+        starts |= 1ULL << i;
+    
+    return starts;
+}
+
+static inline unsigned long long alg_simd_fold(unsigned long long mask, int esize)
+{
+    int i;
+    
+    for(i=1; i<esize; i*=2)
+        mask &= mask >> i;
+    
+    return mask;
+}
+
+// scans whole blocks from index from on and stops after the block that
+// brought the number of matches to max, *next is where to continue
+#define ALG_SIMD_SCAN(width, bytemask) \
+{ \
+    int i, per = width/esize, found = 0; \
+    unsigned long long m, all = width == 64 ? ~0ULL : (1ULL << width)-1; \
+    unsigned long long starts = alg_simd_starts(esize, width); \
+    \
+    for(i=from; i+per <= count && found < max; i+=per) \
+    { \
+        const char *ptr = mem+(long)i*esize; \
+        m = bytemask; \
+        m = alg_simd_fold((m | ~care) & all, esize) & starts; \
+        for(; m; m &= m-1) \
+        { \
+            if(dst) \
+                dst[found] = i+__builtin_ctzll(m)/esize; \
+            found++; \
+        } \
+    } \
+    \
+    *next = i; \
+    return found; \
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+__attribute__((target("sse2")))
+static int alg_simd_scan_sse2(const char *mem, int from, int count, int esize,
+    const char *pattern, unsigned long long care, int *dst, int max, int *next)
+{
+    __m128i p = _mm_loadu_si128((const __m128i*)pattern);
+    ALG_SIMD_SCAN(16, (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(
+        _mm_loadu_si128((const __m128i*)ptr), p)));
+}
+
+__attribute__((target("avx2")))
+static int alg_simd_scan_avx2(const char *mem, int from, int count, int esize,
+    const char *pattern, unsigned long long care, int *dst, int max, int *next)
+{
+    __m256i p = _mm256_loadu_si256((const __m256i*)pattern);
+    ALG_SIMD_SCAN(32, (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256((const __m256i*)ptr), p)));
+}
+
+__attribute__((target("avx512f,avx512bw")))
+static int alg_simd_scan_avx512(const char *mem, int from, int count, int esize,
+    const char *pattern, unsigned long long care, int *dst, int max, int *next)
+{
+    __m512i p = _mm512_loadu_si512((const void*)pattern);
+    ALG_SIMD_SCAN(64, _mm512_cmpeq_epi8_mask(_mm512_loadu_si512((const void*)ptr), p));
+}
+
+// picks the widest kernel the cpu supports, width receives its block size
+static inline alg_simd_scanfun* alg_simd_select(int *width)
+{
+    static alg_simd_scanfun *fun;
+    static int size;
+    
+    if(!fun)
+    {
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512bw"))
+            size = 64, fun = alg_simd_scan_avx512;
+        else if(__builtin_cpu_supports("avx2"))
+            size = 32, fun = alg_simd_scan_avx2;
+        else
+            size = 16, fun = alg_simd_scan_sse2;
+    }
+    
+    *width = size;
+    return fun;
+}
+
+#else
+
+static int alg_simd_scan_none(const char *mem, int from, int count, int esize,
+    const char *pattern, unsigned long long care, int *dst, int max, int *next)
+{
+    *next = from;
+    return 0;
+}
+
+static inline alg_simd_scanfun* alg_simd_select(int *width)
+{
+    *width = 0;
+    return alg_simd_scan_none;
+}
+
+#endif
+
+// fills pattern and care for the kernel, returns 0 if the record size
+// can not be handled by a kernel of the given width
+static inline int alg_simd_prepare(const void *key, int keysize, int esize, int width,
+    char *pattern, unsigned long long *care)
+{
+    unsigned long long bits;
+    int i;
+    
+    if(!width || esize > width || (esize & (esize-1)))
+        return 0;
+    
+    bits = keysize == 64 ? ~0ULL : (1ULL << keysize)-1;
+    memset(pattern, 0, ALG_SIMD_WIDTH);
+    *care = 0;
+    for(i=0; i<width; i+=esize)
+    {
+        memcpy(pattern+i, key, keysize);
+        *care |= bits << i;
+    }
+    
+    return 1;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_STATS_H__
+#define __ALG_STATS_H__
+
+// Operation counters, only counted with ALG_STATS defined. Containers always
+// carry a struct alg_stats at their end so their layout does not depend on
+// the flag, without it the ALG_STAT updates vanish and the *_stats getters
+// report ALG_ERROR_UNSET.
+
+struct alg_stats
+{
+    unsigned long grows, shrinks;   // capacity changes
+    unsigned long copied;           // bytes carried over by capacity changes
+    unsigned long moved;            // bytes shifted by memmove
+    unsigned long hops;             // nodes walked
+    unsigned long allocs, frees;    // allocator calls
+};
+
+#ifdef ALG_STATS
+#define ALG_STAT(obj, field, n) ((obj)->stats.field += (n))
+#else
+#define ALG_STAT(obj, field, n)
+#endif
+
+#endif
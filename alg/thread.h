@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_THREAD_H__
+#define __ALG_THREAD_H__
+
+#include <pthread.h>
+#include <unistd.h>
+
+#define ALG_THREAD_MAX  256
+#define ALG_CACHE_LINE  64
+
+typedef void* alg_threadfun(void *arg);
+
+// 0 or less selects one thread per online processor
+static inline int alg_thread_count(int threads)
+{
+    if(threads <= 0)
+        threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads <= 0)
+        threads = 1;
+    if(threads > ALG_THREAD_MAX)
+        threads = ALG_THREAD_MAX;
+    return threads;
+}
+
+// runs fun on count consecutive args of argsize bytes and waits for all of
+// them, the calling thread takes the first one and work that fails to get
+// a thread of its own runs on the caller as well
+static inline void alg_thread_run(int count, alg_threadfun fun, void *args, size_t argsize)
+{
+    pthread_t threads[ALG_THREAD_MAX];
+    char started[ALG_THREAD_MAX];
+    int i;
+    
+    for(i=1; i<count; i++)
+        started[i] = !pthread_create(&threads[i], 0, fun, (char*)args+i*argsize);
+    
+    if(count > 0)
+        fun(args);
+    
+    for(i=1; i<count; i++)
+        if(started[i])
+            pthread_join(threads[i], 0);
+        else
+            fun((char*)args+i*argsize);
+}
+
+#endif
@@ -0,0 +1,633 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "ulist.h"
+#include "error.h"
+#include "help.h"
+#include <string.h>
+
+struct ulist_node* ulist_intern_node(struct ulist *l)
+{
+    struct ulist_node *node = alg_alloc(sizeof(struct ulist_node)+l->capacity*l->esize, l->alloc);
+    if(!node)
+        RETZ(ALG_ERROR_NO_MEMORY, l);
+    
+    node->next = 0;
+    node->prev = 0;
+    node->count = 0;
+    
+    RET(node, l);
+}
+
+// links node behind prev, or in front of everything if prev is null
+void ulist_intern_link(struct ulist_node *prev, struct ulist_node *node, struct ulist *l)
+{
+    node->prev = prev;
+    node->next = prev ? prev->next : l->first;
+    
+    if(node->next)
+        node->next->prev = node;
+    else
+        l->last = node;
+    
+    if(prev)
+        prev->next = node;
+    else
+        l->first = node;
+}
+
+void ulist_intern_unlink(struct ulist_node *node, struct ulist *l)
+{
+    if(node->prev)
+        node->prev->next = node->next;
+    else
+        l->first = node->next;
+    
+    if(node->next)
+        node->next->prev = node->prev;
+    else
+        l->last = node->prev;
+    
+    alg_free(node, l->alloc);
+}
+
+struct ulist_node* ulist_intern_get(int pos, int *idx, struct ulist *l)
+{
+    struct ulist_node *node;
+    
+    // skip whole nodes by their counts from the nearer end
+    if(pos >= l->size/2)
+    {
+        pos = l->size - pos -1;
+        for(node=l->last; pos >= node->count; node=node->prev)
+            pos -= node->count;
+        *idx = node->count - pos -1;
+    }
+    else
+    {
+        for(node=l->first; pos >= node->count; node=node->next)
+            pos -= node->count;
+        *idx = pos;
+    }
+    
+    return node;
+}
+
+struct ulist_node* ulist_intern_iterate(alg_foldfun fun, void *state, int *idx, struct ulist *l)
+{
+    struct ulist_node *node;
+    int i, pos = 0, ret;
+    
+    for(node=l->first; node; node=node->next)
+        for(i=0; i<node->count; i++, pos++)
+        {
+            ret = fun(pos, node->mem+i*l->esize, state);
+            if(ret < 0)
+                RETZ(ret, l);
+            if(ret > 0)
+            {
+                *idx = i;
+                RET(node, l);
+            }
+        }
+    
+    RETZ(ALG_ERROR_NOT_FOUND, l);
+}
+
+void* ulist_intern_insert(struct ulist_node *node, int idx, void *elem, struct ulist *l)
+{
+    struct ulist_node *next;
+    void *ptr;
+    int half;
+    
+    // a full node hands its upper half to a new neighbour
+    if(node->count == l->capacity)
+    {
+        next = ulist_intern_node(l);
+        CATCHZ(l);
+        ulist_intern_link(node, next, l);
+        
+        half = node->count/2;
+        next->count = node->count-half;
+        node->count = half;
+        memcpy(next->mem, node->mem+half*l->esize, next->count*l->esize);
+        
+        if(idx > half)
+        {
+            node = next;
+            idx -= half;
+        }
+    }
+    
+    ptr = node->mem+idx*l->esize;
+    memmove(ptr+l->esize, ptr, (node->count-idx)*l->esize);
+    
+    if(elem)
+        memcpy(ptr, elem, l->esize);
+    else
+        memset(ptr, 0, l->esize);
+    
+    node->count++;
+    l->size++;
+    
+    RET(ptr, l);
+}
+
+void ulist_intern_remove(struct ulist_node *node, int idx, struct ulist *l)
+{
+    struct ulist_node *other;
+    void *ptr = node->mem+idx*l->esize;
+    
+    memmove(ptr, ptr+l->esize, (node->count-idx-1)*l->esize);
+    node->count--;
+    l->size--;
+    
+    if(!node->count)
+    {
+        ulist_intern_unlink(node, l);
+        return;
+    }
+    
+    if(node->count >= l->capacity/2)
+        return;
+    
+    // merge with a neighbour once both fit into one node
+    if((other = node->next) && node->count+other->count <= l->capacity)
+    {
+        memcpy(node->mem+node->count*l->esize, other->mem, other->count*l->esize);
+        node->count += other->count;
+        ulist_intern_unlink(other, l);
+    }
+    else if((other = node->prev) && node->count+other->count <= l->capacity)
+    {
+        memcpy(other->mem+other->count*l->esize, node->mem, node->count*l->esize);
+        other->count += node->count;
+        ulist_intern_unlink(node, l);
+    }
+}
+
+int ulist_init(int elemsize, struct ulist **l)
+{
+    return ulist_init_alloc(elemsize, 0, l);
+}
+
+int ulist_init_alloc(int elemsize, struct alg_allocator *alloc, struct ulist **pl)
+{
+    int malloced = 0;
+    struct ulist *l;
+    
+    if(elemsize <= 0)
+        return ALG_ERROR_BAD_SIZE;
+    
+    if(!pl)
+        return ALG_ERROR_BAD_DESTINATION;
+    
+    if(!*pl)
+    {
+        malloced = 1;
+        *pl = alg_alloc(sizeof(struct ulist), alloc);
+        if(!*pl)
+            return ALG_ERROR_NO_MEMORY;
+    }
+    
+    l = *pl;
+    l->esize = elemsize;
+    l->size = 0;
+    l->first = 0;
+    l->last = 0;
+    l->alloc = alloc;
+    l->status = ALG_STATUS_MALLOCED*malloced;
+    
+    // nodes span ALG_ULIST_LINES cache lines including their header
+    l->capacity = (ALG_ULIST_LINES*64-sizeof(struct ulist_node))/elemsize;
+    if(l->capacity < ALG_ULIST_MIN)
+        l->capacity = ALG_ULIST_MIN;
+    
+    RET(ALG_SUCCESS, l);
+}
+
+int ulist_finish(struct ulist *l)
+{
+    return ulist_finish_custom(0, 0, l);
+}
+
+int ulist_finish_custom(alg_foldfun fun, void *state, struct ulist *l)
+{
+    ulist_clear_custom(fun, state, l);
+    CATCHE(l);
+    
+    if(l->status & ALG_STATUS_MALLOCED)
+        alg_free(l, l->alloc);
+    else
+        memset(l, 0, sizeof(struct ulist));
+    
+    return ALG_SUCCESS;
+}
+
+void* ulist_at(int pos, struct ulist *l)
+{
+    struct ulist_node *node;
+    int idx;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(pos < 0 || pos >= l->size)
+        RETZ(ALG_ERROR_INDEX_RANGE, l);
+    
+    node = ulist_intern_get(pos, &idx, l);
+    
+    RET(node->mem+idx*l->esize, l);
+}
+
+void* ulist_get(int pos, void *dst, struct ulist *l)
+{
+    void *ptr;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!dst)
+        RETZ(ALG_ERROR_BAD_DESTINATION, l);
+    
+    ptr = ulist_at(pos, l);
+    CATCHZ(l);
+    
+    memcpy(dst, ptr, l->esize);
+    
+    RET(ptr, l);
+}
+
+void* ulist_find(alg_foldfun fun, void *state, struct ulist *l)
+{
+    struct ulist_node *node;
+    int idx;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    node = ulist_intern_iterate(fun, state, &idx, l);
+    CATCHZ(l);
+    
+    RET(node->mem+idx*l->esize, l);
+}
+
+void* ulist_first(struct ulist *l)
+{
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!l->first)
+        RETZ(ALG_ERROR_EMPTY, l);
+    
+    RET(l->first->mem, l);
+}
+
+void* ulist_last(struct ulist *l)
+{
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!l->last)
+        RETZ(ALG_ERROR_EMPTY, l);
+    
+    RET(l->last->mem+(l->last->count-1)*l->esize, l);
+}
+
+int ulist_size(struct ulist *l)
+{
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    RET(l->size, l);
+}
+
+void* ulist_push(void *elem, struct ulist *l)
+{
+    struct ulist_node *node;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    // appending fills the last node up instead of splitting it
+    if(!l->last || l->last->count == l->capacity)
+    {
+        node = ulist_intern_node(l);
+        CATCHZ(l);
+        ulist_intern_link(l->last, node, l);
+    }
+    
+    return ulist_intern_insert(l->last, l->last->count, elem, l);
+}
+
+void* ulist_ins(int pos, void *elem, struct ulist *l)
+{
+    struct ulist_node *node;
+    int idx;
+    
+    if(!l)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(pos < 0 || pos >= l->size)
+        RETZ(ALG_ERROR_INDEX_RANGE, l);
+    
+    node = ulist_intern_get(pos, &idx, l);
+    
+    return ulist_intern_insert(node, idx, elem, l);
+}
+
+void ulist_pop(void *dst, struct ulist *l)
+{
+    ulist_pop_custom(dst, 0, l);
+}
+
+void ulist_pop_custom(void *dst, alg_mapfun fun, struct ulist *l)
+{
+    void *ptr;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!l->last)
+        RETV(ALG_ERROR_EMPTY, l);
+    
+    ptr = l->last->mem+(l->last->count-1)*l->esize;
+    
+    if(dst)
+        memcpy(dst, ptr, l->esize);
+    
+    if(fun)
+        fun(ptr);
+    
+    ulist_intern_remove(l->last, l->last->count-1, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void ulist_del(int pos, struct ulist *l)
+{
+    ulist_rem_custom(pos, 0, 0, l);
+}
+
+void ulist_del_custom(int pos, alg_mapfun fun, struct ulist *l)
+{
+    ulist_rem_custom(pos, 0, fun, l);
+}
+
+void ulist_rem(int pos, void *dst, struct ulist *l)
+{
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!dst)
+        RETV(ALG_ERROR_BAD_DESTINATION, l);
+    
+    ulist_rem_custom(pos, dst, 0, l);
+}
+
+void ulist_rem_custom(int pos, void *dst, alg_mapfun fun, struct ulist *l)
+{
+    struct ulist_node *node;
+    void *ptr;
+    int idx;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(pos < 0 || pos >= l->size)
+        RETV(ALG_ERROR_INDEX_RANGE, l);
+    
+    node = ulist_intern_get(pos, &idx, l);
+    ptr = node->mem+idx*l->esize;
+    
+    if(dst)
+        memcpy(dst, ptr, l->esize);
+    
+    if(fun)
+        fun(ptr);
+    
+    ulist_intern_remove(node, idx, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void ulist_find_del(alg_foldfun fun, void *state, struct ulist *l)
+{
+    struct ulist_node *node;
+    int idx;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    node = ulist_intern_iterate(fun, state, &idx, l);
+    CATCHV(l);
+    
+    ulist_intern_remove(node, idx, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void ulist_find_rem(alg_foldfun fun, void *state, void *dst, struct ulist *l)
+{
+    struct ulist_node *node;
+    int idx;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    if(!dst)
+        RETV(ALG_ERROR_BAD_DESTINATION, l);
+    
+    node = ulist_intern_iterate(fun, state, &idx, l);
+    CATCHV(l);
+    
+    memcpy(dst, node->mem+idx*l->esize, l->esize);
+    ulist_intern_remove(node, idx, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void ulist_fold(alg_foldfun fun, void *state, struct ulist *l)
+{
+    struct ulist_node *node;
+    int i, pos = 0, ret;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    for(node=l->first; node; node=node->next)
+        for(i=0; i<node->count; i++, pos++)
+            if((ret = fun(pos, node->mem+i*l->esize, state)) != ALG_SUCCESS)
+                RETV(ret, l);
+    
+    l->error = ALG_SUCCESS;
+}
+
+void ulist_clear(struct ulist *l)
+{
+    ulist_clear_custom(0, 0, l);
+}
+
+void ulist_clear_custom(alg_foldfun fun, void *state, struct ulist *l)
+{
+    struct ulist_node *node, *next;
+    int i, pos = 0;
+    
+    if(!l)
+        RETV(ALG_ERROR_BAD_STRUCTURE, l);
+    
+    for(node=l->first; node; node=next)
+    {
+        next = node->next;
+        if(fun)
+            for(i=0; i<node->count; i++, pos++)
+                fun(pos, node->mem+i*l->esize, state);
+        alg_free(node, l->alloc);
+    }
+    
+    l->first = 0;
+    l->last = 0;
+    l->size = 0;
+    l->error = ALG_SUCCESS;
+}
+
+#ifdef ALG_TEST
+
+#include <stdio.h>
+
+void show_ulist(struct ulist *l)
+{
+    struct ulist_node *node;
+    int i;
+    
+    printf("size: %i | nodes:", l->size);
+    if(!l->first)
+        printf(" empty");
+    for(node=l->first; node; node=node->next)
+    {
+        printf(" [");
+        for(i=0; i<node->count; i++)
+            printf(i ? ", %i" : "%i", ((int*)node->mem)[i]);
+        printf("]");
+    }
+    printf("\n");
+}
+
+int catch(struct ulist *l)
+{
+    if(l->error != ALG_SUCCESS)
+    {
+        printf("error: %s\n", alg_str_error(l->error));
+        return 1;
+    }
+    return 0;
+}
+
+int test_fun(int pos, void *elem, void *state)
+{
+    if(*(int*)elem == *(int*)state)
+        return 1;
+    return 0;
+}
+
+int test_sum(int pos, void *elem, void *state)
+{
+    *(int*)state += *(int*)elem;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct ulist *l = 0;
+    int i, j, *elem;
+    
+    if(ulist_init_alloc(sizeof(int), 0, &l) != ALG_SUCCESS)
+        return 1;
+    l->capacity = 4;
+    show_ulist(l);
+    
+    for(i=0; i<10; i++)
+    {
+        ulist_push(&i, l);
+        if(catch(l))
+            return 1;
+    }
+    show_ulist(l);
+    
+    i = 42;
+    ulist_ins(1, &i, l);
+    if(catch(l))
+        return 1;
+    show_ulist(l);
+    i = 23;
+    ulist_ins(l->size-1, &i, l);
+    if(catch(l))
+        return 1;
+    show_ulist(l);
+    
+    elem = ulist_at(7, l);
+    if(catch(l))
+        return 1;
+    printf("pos 7: %i\n", *elem);
+    
+    ulist_del(0, l);
+    ulist_del(0, l);
+    if(catch(l))
+        return 1;
+    show_ulist(l);
+    
+    ulist_rem(4, &j, l);
+    if(catch(l))
+        return 1;
+    printf("elem: %i | ", j);
+    show_ulist(l);
+    
+    j = 23;
+    ulist_find_del(test_fun, &j, l);
+    if(catch(l))
+        return 1;
+    show_ulist(l);
+    
+    ulist_pop(&j, l);
+    if(catch(l))
+        return 1;
+    printf("elem: %i | ", j);
+    show_ulist(l);
+    
+    j = 0;
+    ulist_fold(test_sum, &j, l);
+    if(catch(l))
+        return 1;
+    printf("sum: %i\n", j);
+    
+    ulist_clear(l);
+    if(catch(l))
+        return 1;
+    show_ulist(l);
+    
+    if(ulist_finish(l) != ALG_SUCCESS)
+        return 1;
+    
+    return 0;
+}
+
+#endif
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_ULIST_H__
+#define __ALG_ULIST_H__
+
+#include "fun.h"
+#include "alloc.h"
+
+#define ALG_ULIST_LINES 4   // cache lines per node
+#define ALG_ULIST_MIN   4   // minimum elements per node
+
+struct ulist_node
+{
+    struct ulist_node *next, *prev;
+    int count;
+    char mem[] __attribute__((aligned(16)));
+};
+
+struct ulist
+{
+    struct ulist_node *first, *last;
+    struct alg_allocator *alloc;
+    int size, esize, capacity, error;
+    char status;
+};
+
+int ulist_init(int elemsize, struct ulist **l);
+int ulist_init_alloc(int elemsize, struct alg_allocator *alloc, struct ulist **l);
+int ulist_finish(struct ulist *l);
+int ulist_finish_custom(alg_foldfun fun, void *state, struct ulist *l);
+
+void* ulist_at(int pos, struct ulist *l);
+void* ulist_get(int pos, void *dst, struct ulist *l);
+void* ulist_find(alg_foldfun fun, void *state, struct ulist *l);
+void* ulist_first(struct ulist *l);
+void* ulist_last(struct ulist *l);
+int   ulist_size(struct ulist *l);
+
+void* ulist_push(void *elem, struct ulist *l);
+void* ulist_ins(int pos, void *elem, struct ulist *l);
+
+void ulist_pop(void *dst, struct ulist *l);
+void ulist_pop_custom(void *dst, alg_mapfun fun, struct ulist *l);
+void ulist_del(int pos, struct ulist *l);
+void ulist_del_custom(int pos, alg_mapfun fun, struct ulist *l);
+void ulist_rem(int pos, void *dst, struct ulist *l);
+void ulist_rem_custom(int pos, void *dst, alg_mapfun fun, struct ulist *l);
+void ulist_find_del(alg_foldfun fun, void *state, struct ulist *l);
+void ulist_find_rem(alg_foldfun fun, void *state, void *dst, struct ulist *l);
+
+void ulist_fold(alg_foldfun fun, void *state, struct ulist *l);
+
+void ulist_clear(struct ulist *l);
+void ulist_clear_custom(alg_foldfun fun, void *state, struct ulist *l);
+
+#endif
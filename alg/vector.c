@@ -20,15 +20,80 @@
  * THE SOFTWARE.
  */
 
+#define _GNU_SOURCE
+
 #include "vector.h"
+#include "alloc.h"
 #include "error.h"
 #include "help.h"
+#include "thread.h"
+#include "simd.h"
+#include "io.h"
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+struct vector_par_state
+{
+    struct vector *vec;
+    alg_foldfun *fold;
+    alg_mapfun *map;
+    void *state;
+    int from, to, ret;
+};
+
+struct vector_sort_state
+{
+    char *src, *dst;
+    alg_cmpfun *cmp;
+    int from, mid, to, esize;
+};
+
+// mapped vectors keep the file as long as the capacity, the header size
+// tells how many records are valid
+void vector_intern_remap(int capacity, struct vector *vec)
+{
+    size_t old = ALG_VECTOR_FILE_HEAD+(size_t)vec->capacity*vec->esize;
+    size_t len = ALG_VECTOR_FILE_HEAD+(size_t)capacity*vec->esize;
+    void *base = vec->mem-ALG_VECTOR_FILE_HEAD;
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(ftruncate(vec->fd, len))
+        RETV(ALG_ERROR_NO_MEMORY, vec);
+    
+    base = mremap(base, old, len, MREMAP_MAYMOVE);
+    if(base == MAP_FAILED)
+        RETV(ALG_ERROR_NO_MEMORY, vec);
+    
+    vec->mem = base+ALG_VECTOR_FILE_HEAD;
+    vec->pos = vec->mem + vec->size*vec->esize;
+    vec->capacity = capacity;
+    
+    vec->error = ALG_SUCCESS;
+}
 
 void vector_grow(int capacity, struct vector *vec)
 {
-    void *tmp = realloc(vec->mem, capacity*vec->esize);
+    void *tmp;
+    
+    ALG_STAT(vec, grows, 1);
+    ALG_STAT(vec, copied, vec->size*vec->esize);
+    
+    if(vec->status & ALG_STATUS_MAPPED)
+    {
+        vector_intern_remap(capacity, vec);
+        return;
+    }
+    
+    tmp = alg_realloc(vec->mem, (size_t)capacity*vec->esize, vec->alloc);
+    ALG_STAT(vec, allocs, 1);
     if(!tmp)
         RETV(ALG_ERROR_NO_MEMORY, vec);
     vec->mem = tmp;
@@ -38,17 +103,70 @@ void vector_grow(int capacity, struct vector *vec)
     vec->error = ALG_SUCCESS;
 }
 
+// the byte size of the memory has to fit an int, so growth stops at max,
+// where the next capacity is the current one
+int vector_intern_next(int capacity, struct vector *vec)
+{
+    long next = (long)capacity*vec->policy.grow;
+    int max = INT_MAX/vec->esize;
+    
+    if(next <= capacity)
+        next = capacity+1L;
+    if(next < vec->policy.capacity)
+        next = vec->policy.capacity;
+    if(next > max)
+        next = max > capacity ? max : capacity;
+    
+    return next;
+}
+
 void vector_autogrow(struct vector *vec)
 {
+    int capacity;
+    
     if(vec->size == vec->capacity)
-        vector_grow(vec->capacity*ALG_VECTOR_GROW, vec);
+    {
+        capacity = vector_intern_next(vec->capacity, vec);
+        if(capacity == vec->capacity)
+            RETV(ALG_ERROR_NO_MEMORY, vec);
+        vector_grow(capacity, vec);
+    }
+    CATCHV(vec);
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_autogrow_n(int count, struct vector *vec)
+{
+    int capacity = vec->capacity;
+    
+    // beyond that not even the largest capacity holds all records
+    if(count > INT_MAX/vec->esize-vec->size)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    while(vec->size+count > capacity)
+        capacity = vector_intern_next(capacity, vec);
+    
+    if(capacity != vec->capacity)
+        vector_grow(capacity, vec);
     CATCHV(vec);
     vec->error = ALG_SUCCESS;
 }
 
 void vector_shrink(int capacity, struct vector *vec)
 {
-    void *tmp = realloc(vec->mem, capacity*vec->esize);
+    void *tmp;
+    
+    ALG_STAT(vec, shrinks, 1);
+    ALG_STAT(vec, copied, vec->size*vec->esize);
+    
+    if(vec->status & ALG_STATUS_MAPPED)
+    {
+        vector_intern_remap(capacity, vec);
+        return;
+    }
+    
+    tmp = alg_realloc(vec->mem, (size_t)capacity*vec->esize, vec->alloc);
+    ALG_STAT(vec, allocs, 1);
     if(!tmp)
         RETV(ALG_ERROR_NO_MEMORY, vec);
     vec->mem = tmp;
@@ -60,13 +178,387 @@ void vector_shrink(int capacity, struct vector *vec)
 
 void vector_autoshrink(struct vector *vec)
 {
-    if(vec->size <= vec->capacity/ALG_VECTOR_SHRINK && vec->capacity > vec->capacited)
-        vector_shrink(vec->capacity/ALG_VECTOR_GROW, vec);
+    int capacity, floor;
+    
+    floor = vec->reserved > vec->policy.capacity ? vec->reserved : vec->policy.capacity;
+    
+    if(vec->policy.shrink && vec->size <= vec->capacity/vec->policy.shrink
+        && vec->capacity > floor)
+    {
+        capacity = vec->capacity/vec->policy.grow;
+        if(capacity < floor)
+            capacity = floor;
+        vector_shrink(capacity, vec);
+    }
     CATCHV(vec);
     vec->error = ALG_SUCCESS;
 }
 
+void* vector_intern_fold(void *arg)
+{
+    struct vector_par_state *par = arg;
+    int i, esize = par->vec->esize;
+    void *ptr = par->vec->mem+par->from*esize;
+    
+    for(i=par->from; i<par->to; i++, ptr += esize)
+        if((par->ret = par->fold(i, ptr, par->state)) != ALG_SUCCESS)
+            break;
+    
+    return 0;
+}
+
+void* vector_intern_map(void *arg)
+{
+    struct vector_par_state *par = arg;
+    int i, esize = par->vec->esize;
+    void *ptr = par->vec->mem+par->from*esize;
+    
+    for(i=par->from; i<par->to; i++, ptr += esize)
+        if((par->ret = par->map(ptr)) != ALG_SUCCESS)
+            break;
+    
+    return 0;
+}
+
+int vector_intern_split(int threads, struct vector_par_state *par, struct vector *vec)
+{
+    int i, a, b, unit, lead, chunk, count;
+    
+    // chunks start on cache line boundaries of the actual addresses, so no
+    // two threads write to the same line, such a boundary comes every unit
+    // records from the first one at lead on, chunk 0 takes those before it
+    for(a=vec->esize, b=ALG_CACHE_LINE; b; i=a%b, a=b, b=i);
+    unit = ALG_CACHE_LINE/a;
+    for(lead=0; lead<unit && ((uintptr_t)vec->mem+lead*vec->esize)%ALG_CACHE_LINE; lead++);
+    
+    // a mem misaligned against the record size never meets a line boundary
+    if(lead == unit)
+        lead = 0;
+    
+    chunk = (vec->size+threads-1)/threads;
+    chunk = (chunk+unit-1)/unit*unit;
+    count = 0;
+    if(chunk)
+        count = vec->size > lead ? (vec->size-lead+chunk-1)/chunk : 1;
+    
+    for(i=0; i<count; i++)
+    {
+        par[i].vec = vec;
+        par[i].from = i ? lead+i*chunk : 0;
+        par[i].to = i == count-1 ? vec->size : lead+(i+1)*chunk;
+        par[i].ret = ALG_SUCCESS;
+    }
+    
+    return count;
+}
+
+int vector_intern_threads(int threads, struct vector *vec)
+{
+    if(vec->size < ALG_VECTOR_PAR_MIN)
+        return 1;
+    return alg_thread_count(threads);
+}
+
+// collects the indices of records starting with key from *from on into dst,
+// stops as soon as max are found but may write up to ALG_SIMD_WIDTH-1 more
+int vector_intern_scan(void *key, int keysize, int *from, int *dst, int max, struct vector *vec)
+{
+    char pattern[ALG_SIMD_WIDTH];
+    unsigned long long care;
+    alg_simd_scanfun *scan;
+    int i, width, found = 0;
+    void *ptr;
+    
+    scan = alg_simd_select(&width);
+    if(alg_simd_prepare(key, keysize, vec->esize, width, pattern, &care))
+    {
+        found = scan(vec->mem, *from, vec->size, vec->esize, pattern, care, dst, max, from);
+        if(found >= max)
+            return found;
+    }
+    
+    for(i=*from, ptr=vec->mem+i*vec->esize; i<vec->size && found < max; i++, ptr += vec->esize)
+        if(!memcmp(ptr, key, keysize))
+        {
+            if(dst)
+                dst[found] = i;
+            found++;
+        }
+    
+    *from = i;
+    return found;
+}
+
+void* vector_intern_scratch(int size, struct vector *vec)
+{
+    void *tmp;
+    
+    // the scratch buffer is kept across calls and only ever grows
+    if(size > vec->scratched)
+    {
+        tmp = alg_realloc(vec->scratch, size, vec->alloc);
+        ALG_STAT(vec, allocs, 1);
+        if(!tmp)
+            RETZ(ALG_ERROR_NO_MEMORY, vec);
+        vec->scratch = tmp;
+        vec->scratched = size;
+    }
+    
+    RET(vec->scratch, vec);
+}
+
+void vector_intern_swap(char *a, char *b, int esize)
+{
+    long l;
+    char c;
+    
+    for(; esize >= sizeof(long); esize -= sizeof(long), a += sizeof(long), b += sizeof(long))
+    {
+        memcpy(&l, a, sizeof(long));
+        memcpy(a, b, sizeof(long));
+        memcpy(b, &l, sizeof(long));
+    }
+    for(; esize > 0; esize--, a++, b++)
+    {
+        c = *a;
+        *a = *b;
+        *b = c;
+    }
+}
+
+void vector_intern_isort(char *mem, int n, int esize, alg_cmpfun cmp, char *tmp)
+{
+    int i, j;
+    
+    for(i=1; i<n; i++)
+    {
+        if(cmp(mem+(i-1)*esize, mem+i*esize) <= 0)
+            continue;
+        memcpy(tmp, mem+i*esize, esize);
+        for(j=i-1; j>0 && cmp(mem+(j-1)*esize, tmp) > 0; j--);
+        memmove(mem+(j+1)*esize, mem+j*esize, (i-j)*esize);
+        memcpy(mem+j*esize, tmp, esize);
+    }
+}
+
+void vector_intern_sift(char *mem, int i, int n, int esize, alg_cmpfun cmp)
+{
+    int c;
+    
+    while((c = 2*i+1) < n)
+    {
+        if(c+1 < n && cmp(mem+c*esize, mem+(c+1)*esize) < 0)
+            c++;
+        if(cmp(mem+i*esize, mem+c*esize) >= 0)
+            return;
+        vector_intern_swap(mem+i*esize, mem+c*esize, esize);
+        i = c;
+    }
+}
+
+void vector_intern_hsort(char *mem, int n, int esize, alg_cmpfun cmp)
+{
+    int i;
+    
+    for(i=n/2-1; i>=0; i--)
+        vector_intern_sift(mem, i, n, esize, cmp);
+    for(i=n-1; i>0; i--)
+    {
+        vector_intern_swap(mem, mem+i*esize, esize);
+        vector_intern_sift(mem, 0, i, esize, cmp);
+    }
+}
+
+// introsort, falls back to heapsort once depth is used up
+void vector_intern_qsort(char *mem, int n, int depth, int esize, alg_cmpfun cmp, char *tmp)
+{
+    char *mid, *last;
+    int i, j;
+    
+    while(n > ALG_VECTOR_SORT_SMALL)
+    {
+        if(!depth--)
+        {
+            vector_intern_hsort(mem, n, esize, cmp);
+            return;
+        }
+        
+        // median of three as pivot at the front, last is no less than it
+        mid = mem+(n/2)*esize;
+        last = mem+(n-1)*esize;
+        if(cmp(mid, mem) < 0)
+            vector_intern_swap(mid, mem, esize);
+        if(cmp(last, mid) < 0)
+        {
+            vector_intern_swap(last, mid, esize);
+            if(cmp(mid, mem) < 0)
+                vector_intern_swap(mid, mem, esize);
+        }
+        vector_intern_swap(mem, mid, esize);
+        
+        i = 0;
+        j = n;
+        while(1)
+        {
+            do i++; while(cmp(mem+i*esize, mem) < 0);
+            do j--; while(cmp(mem, mem+j*esize) < 0);
+            if(i >= j)
+                break;
+            vector_intern_swap(mem+i*esize, mem+j*esize, esize);
+        }
+        vector_intern_swap(mem, mem+j*esize, esize);
+        
+        // recurse into the smaller part, loop on the larger one
+        if(j < n-j-1)
+        {
+            vector_intern_qsort(mem, j, depth, esize, cmp, tmp);
+            mem += (j+1)*esize;
+            n -= j+1;
+        }
+        else
+        {
+            vector_intern_qsort(mem+(j+1)*esize, n-j-1, depth, esize, cmp, tmp);
+            n = j;
+        }
+    }
+    
+    vector_intern_isort(mem, n, esize, cmp, tmp);
+}
+
+void vector_intern_merge(struct vector_sort_state *s)
+{
+    char *a = s->src+s->from*s->esize, *am = s->src+s->mid*s->esize;
+    char *b = am, *bm = s->src+s->to*s->esize, *dst = s->dst+s->from*s->esize;
+    
+    // runs already in order are copied as a whole
+    if(a < am && b < bm && s->cmp(am-s->esize, b) <= 0)
+    {
+        memcpy(dst, a, bm-a);
+        return;
+    }
+    
+    while(a < am && b < bm)
+    {
+        if(s->cmp(b, a) < 0)
+        {
+            memcpy(dst, b, s->esize);
+            b += s->esize;
+        }
+        else
+        {
+            memcpy(dst, a, s->esize);
+            a += s->esize;
+        }
+        dst += s->esize;
+    }
+    memcpy(dst, a, am-a);
+    memcpy(dst+(am-a), b, bm-b);
+}
+
+// stable bottom up merge sort of n records, tmp has room for n records
+void vector_intern_msort(char *mem, char *tmp, int n, int esize, alg_cmpfun cmp)
+{
+    struct vector_sort_state s;
+    char *swap;
+    int i, width;
+    
+    for(i=0; i<n; i+=ALG_VECTOR_SORT_SMALL)
+        vector_intern_isort(mem+i*esize, n-i < ALG_VECTOR_SORT_SMALL ? n-i : ALG_VECTOR_SORT_SMALL, esize, cmp, tmp);
+    
+    s.src = mem;
+    s.dst = tmp;
+    s.cmp = cmp;
+    s.esize = esize;
+    
+    for(width=ALG_VECTOR_SORT_SMALL; width<n; width*=2)
+    {
+        for(i=0; i<n; i+=2*width)
+        {
+            s.from = i;
+            s.mid = i+width < n ? i+width : n;
+            s.to = i+2*width < n ? i+2*width : n;
+            vector_intern_merge(&s);
+        }
+        swap = s.src;
+        s.src = s.dst;
+        s.dst = swap;
+    }
+    
+    if(s.src != mem)
+        memcpy(mem, s.src, n*esize);
+}
+
+void* vector_intern_msort_par(void *arg)
+{
+    struct vector_sort_state *s = arg;
+    vector_intern_msort(s->src+s->from*s->esize, s->dst+s->from*s->esize, s->to-s->from, s->esize, s->cmp);
+    return 0;
+}
+
+void* vector_intern_merge_par(void *arg)
+{
+    vector_intern_merge(arg);
+    return 0;
+}
+
+// index of the first element not less (upper: greater) than key, the
+// comparison result is used as an offset instead of a branch
+int vector_intern_bound(void *key, alg_cmpfun cmp, int upper, struct vector *vec)
+{
+    char *base = vec->mem;
+    int half, n = vec->size;
+    
+    if(!n)
+        return 0;
+    
+    while(n > 1)
+    {
+        half = n/2;
+        base += (upper ? cmp(base+half*vec->esize, key) <= 0 : cmp(base+half*vec->esize, key) < 0)*half*vec->esize;
+        n -= half;
+    }
+    base += (upper ? cmp(base, key) <= 0 : cmp(base, key) < 0)*vec->esize;
+    
+    return (base-(char*)vec->mem)/vec->esize;
+}
+
+// fills dst in breadth first order from the in order walk over src
+int vector_intern_eytzinger(char *src, int i, int k, char *dst, struct vector *vec)
+{
+    if(k <= vec->size)
+    {
+        i = vector_intern_eytzinger(src, i, 2*k, dst, vec);
+        memcpy(dst+(k-1)*vec->esize, src+i*vec->esize, vec->esize);
+        i = vector_intern_eytzinger(src, i+1, 2*k+1, dst, vec);
+    }
+    return i;
+}
+
+int vector_intern_unmap(struct vector *vec)
+{
+    void *base = vec->mem-ALG_VECTOR_FILE_HEAD;
+    size_t len = ALG_VECTOR_FILE_HEAD+(size_t)vec->capacity*vec->esize;
+    int ret = ALG_SUCCESS;
+    
+    if(!(vec->status & ALG_STATUS_RDONLY))
+        ((struct alg_io_head*)base)->size = vec->size;
+    munmap(base, len);
+    
+    // trim the unused capacity off the file
+    if(!(vec->status & ALG_STATUS_RDONLY)
+        && ftruncate(vec->fd, ALG_VECTOR_FILE_HEAD+(size_t)vec->size*vec->esize))
+        ret = ALG_ERROR_BAD_DESTINATION;
+    close(vec->fd);
+    
+    return ret;
+}
+
 int vector_init(int elemsize, struct vector **vec)
+{
+    return vector_init_alloc(elemsize, 0, vec);
+}
+
+int vector_init_alloc(int elemsize, struct alg_allocator *alloc, struct vector **vec)
 {
     int malloced = 0;
     struct vector *v;
@@ -80,7 +572,7 @@ int vector_init(int elemsize, struct vector **vec)
     if(!*vec)
     {
         malloced = 1;
-        *vec = malloc(sizeof(struct vector));
+        *vec = alg_alloc(sizeof(struct vector), alloc);
         if(!*vec)
             return ALG_ERROR_NO_MEMORY;
     }
@@ -90,13 +582,24 @@ int vector_init(int elemsize, struct vector **vec)
     v->esize = elemsize;
     v->capacity = ALG_VECTOR_CAPACITY;
     v->status = ALG_STATUS_MALLOCED*malloced;
-    v->capacited = ALG_VECTOR_CAPACITY;
-    v->mem = malloc(elemsize*ALG_VECTOR_CAPACITY);
+    v->idle = 0;
+    v->reserved = 0;
+    v->scratch = 0;
+    v->scratched = 0;
+    v->fd = -1;
+    v->policy.grow = ALG_VECTOR_GROW;
+    v->policy.shrink = ALG_VECTOR_SHRINK;
+    v->policy.capacity = ALG_VECTOR_CAPACITY;
+    v->policy.decay = ALG_VECTOR_DECAY;
+    v->alloc = alloc;
+    v->mem = alg_alloc(elemsize*ALG_VECTOR_CAPACITY, alloc);
+    memset(&v->stats, 0, sizeof(struct alg_stats));
+    ALG_STAT(v, allocs, 1);
     
     if(!v->mem)
     {
         if(malloced)
-            free(v);
+            alg_free(v, alloc);
         return ALG_ERROR_NO_MEMORY;
     }
     
@@ -105,6 +608,100 @@ int vector_init(int elemsize, struct vector **vec)
     RET(ALG_SUCCESS, v);
 }
 
+int vector_map_file(const char *path, int elemsize, int flags, struct vector **vec)
+{
+    struct alg_io_head head;
+    struct stat st;
+    struct vector *v;
+    void *base;
+    size_t len;
+    int ret, fd, rdonly = flags & ALG_VECTOR_MAP_RDONLY;
+    
+    if(!path)
+        return ALG_ERROR_BAD_SOURCE;
+    
+    if((ret = vector_init(elemsize, vec)) != ALG_SUCCESS)
+        return ret;
+    v = *vec;
+    
+    fd = open(path, rdonly ? O_RDONLY : O_RDWR | (flags & ALG_VECTOR_MAP_CREATE ? O_CREAT : 0), 0644);
+    if(fd < 0 || fstat(fd, &st))
+    {
+        ret = ALG_ERROR_BAD_SOURCE;
+        goto fail;
+    }
+    
+    if(!st.st_size && !rdonly)
+    {
+        // fresh file, room for the default capacity
+        memset(&head, 0, sizeof(struct alg_io_head));
+        memcpy(head.magic, ALG_IO_MAGIC, sizeof(head.magic));
+        head.esize = elemsize;
+        len = ALG_VECTOR_FILE_HEAD+(size_t)v->capacity*elemsize;
+        if(ftruncate(fd, len) || pwrite(fd, &head, sizeof(struct alg_io_head), 0) != sizeof(struct alg_io_head))
+        {
+            ret = ALG_ERROR_NO_MEMORY;
+            goto fail;
+        }
+    }
+    else
+    {
+        if(st.st_size < ALG_VECTOR_FILE_HEAD
+            || pread(fd, &head, sizeof(struct alg_io_head), 0) != sizeof(struct alg_io_head)
+            || memcmp(head.magic, ALG_IO_MAGIC, sizeof(head.magic)))
+        {
+            ret = ALG_ERROR_BAD_SOURCE;
+            goto fail;
+        }
+        if(head.esize != elemsize || head.size < 0 || head.size > INT_MAX/elemsize
+            || ALG_VECTOR_FILE_HEAD+head.size*elemsize > st.st_size)
+        {
+            ret = ALG_ERROR_BAD_SIZE;
+            goto fail;
+        }
+        len = rdonly ? ALG_VECTOR_FILE_HEAD+head.size*elemsize : st.st_size;
+        if((len-ALG_VECTOR_FILE_HEAD)/elemsize > INT_MAX)
+        {
+            ret = ALG_ERROR_BAD_SIZE;
+            goto fail;
+        }
+    }
+    
+    // read only mappings cannot be written at all, mutators refuse them
+    base = mmap(0, len, rdonly ? PROT_READ : PROT_READ|PROT_WRITE, MAP_SHARED
+        | (flags & ALG_VECTOR_MAP_POPULATE ? MAP_POPULATE : 0), fd, 0);
+    if(base == MAP_FAILED)
+    {
+        ret = ALG_ERROR_NO_MEMORY;
+        goto fail;
+    }
+    
+    if(flags & ALG_VECTOR_MAP_RANDOM)
+        madvise(base, len, MADV_RANDOM);
+    if(flags & ALG_VECTOR_MAP_SEQUENTIAL)
+        madvise(base, len, MADV_SEQUENTIAL);
+    
+    alg_free(v->mem, v->alloc);
+    ALG_STAT(v, frees, 1);
+    v->mem = base+ALG_VECTOR_FILE_HEAD;
+    v->size = head.size;
+    v->pos = v->mem+v->size*elemsize;
+    v->capacity = (len-ALG_VECTOR_FILE_HEAD)/elemsize;
+    v->fd = fd;
+    v->status |= ALG_STATUS_MAPPED | (rdonly ? ALG_STATUS_RDONLY : 0);
+    
+    // remapping on every pop would be wasted work
+    v->policy.shrink = 0;
+    
+    RET(ALG_SUCCESS, v);
+
+fail:
+    if(fd >= 0)
+        close(fd);
+    vector_finish(v);
+    return ret;
+}
+
 int vector_finish(struct vector *vec)
 {
     return vector_finish_custom(0, 0, vec);
@@ -123,28 +720,38 @@ int vector_finish_custom(alg_foldfun fun, void *state, struct vector *vec)
             if((ret = fun(i, state, ptr)) != ALG_SUCCESS)
                 RETE(ret, vec);
     
-    free(vec->mem);
+    // the vector is released even if the file could not be trimmed
+    ret = ALG_SUCCESS;
+    if(vec->status & ALG_STATUS_MAPPED)
+        ret = vector_intern_unmap(vec);
+    else
+        alg_free(vec->mem, vec->alloc);
+    if(vec->scratch)
+        alg_free(vec->scratch, vec->alloc);
     if(vec->status & ALG_STATUS_MALLOCED)
-        free(vec);
+        alg_free(vec, vec->alloc);
     else
         memset(vec, 0, sizeof(struct vector));
     
-    return ALG_SUCCESS;
+    return ret;
 }
 
 void* vector_at(int pos, struct vector *vec)
 {
+#ifndef ALG_UNCHECKED
     if(!vec)
         RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
     if(pos < 0 || pos >= vec->size)
         RETZ(ALG_ERROR_INDEX_RANGE, vec);
+#endif
     
-    RET(vec->mem + pos*vec->esize, vec);
+    RETA(vector_at_unchecked(pos, vec), vec);
 }
 
 void* vector_get(int pos, void *dst, struct vector *vec)
 {
+#ifndef ALG_UNCHECKED
     if(!vec)
         RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
@@ -153,63 +760,132 @@ void* vector_get(int pos, void *dst, struct vector *vec)
     
     if(pos < 0 || pos >= vec->size)
         RETZ(ALG_ERROR_INDEX_RANGE, vec);
+#endif
     
-    memcpy(dst, vec->mem+pos*vec->esize, vec->esize);
+    memcpy(dst, vector_at_unchecked(pos, vec), vec->esize);
     
-    RET(vec->mem+pos*vec->esize, vec);
+    RETA(vector_at_unchecked(pos, vec), vec);
 }
 
 int vector_size(struct vector *vec)
 {
+#ifndef ALG_UNCHECKED
     if(!vec)
         RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+#endif
     
-    RET(vec->size, vec);
+    RETA(vec->size, vec);
 }
 
 int vector_capacity(struct vector *vec)
 {
+#ifndef ALG_UNCHECKED
     if(!vec)
         RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+#endif
     
-    RET(vec->capacity, vec);
+    RETA(vec->capacity, vec);
 }
 
 void* vector_push(void *elem, struct vector *vec)
 {
+    void *ptr;
+    
     if(!vec)
         RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
     if(!elem)
         RETZ(ALG_ERROR_BAD_SOURCE, vec);
     
-    vector_autogrow(vec);
+    ptr = vector_emplace_back(vec);
     CATCHZ(vec);
     
-    memcpy(vec->pos, elem, vec->esize);
-    vec->pos += vec->esize;
-    vec->size++;
+    memcpy(ptr, elem, vec->esize);
     
-    RET(vec->pos-vec->esize, vec);
-}
-
-void vector_pop(void *dst, struct vector *vec)
-{
-    vector_pop_custom(dst, 0, vec);
+    RET(ptr, vec);
 }
 
-void vector_pop_custom(void *dst, alg_mapfun fun, struct vector *vec)
+void* vector_push_n(void *elems, int count, struct vector *vec)
 {
-    int ret;
+    void *ptr;
     
     if(!vec)
-        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    if(!vec->size)
-        RETV(ALG_ERROR_EMPTY, vec);
+    if(!elems)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
     
-    vec->pos -= vec->esize;
+    ptr = vector_emplace_back_n(count, vec);
+    CATCHZ(vec);
+    
+    memcpy(ptr, elems, count*vec->esize);
+    
+    RET(ptr, vec);
+}
+
+void* vector_emplace_back(struct vector *vec)
+{
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    vector_autogrow(vec);
+    CATCHZ(vec);
+    
+    vec->pos += vec->esize;
+    vec->size++;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    RET(vec->pos-vec->esize, vec);
+}
+
+void* vector_emplace_back_n(int count, struct vector *vec)
+{
+    void *ptr;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(count <= 0)
+        RETZ(ALG_ERROR_BAD_SIZE, vec);
+    
+    vector_autogrow_n(count, vec);
+    CATCHZ(vec);
+    
+    ptr = vec->pos;
+    vec->pos += count*vec->esize;
+    vec->size += count;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    RET(ptr, vec);
+}
+
+void vector_pop(void *dst, struct vector *vec)
+{
+    vector_pop_custom(dst, 0, vec);
+}
+
+void vector_pop_custom(void *dst, alg_mapfun fun, struct vector *vec)
+{
+    int ret;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!vec->size)
+        RETV(ALG_ERROR_EMPTY, vec);
+    
+    vec->pos -= vec->esize;
     vec->size--;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
     if(dst)
         memcpy(dst, vec->pos, vec->esize);
     
@@ -232,17 +908,63 @@ void* vector_ins(int pos, void *elem, struct vector *vec)
     if(!elem)
         RETZ(ALG_ERROR_BAD_SOURCE, vec);
     
+    ptr = vector_emplace_at_n(pos, 1, vec);
+    CATCHZ(vec);
+    
+    memcpy(ptr, elem, vec->esize);
+    
+    RET(ptr, vec);
+}
+
+void* vector_ins_n(int pos, void *elems, int count, struct vector *vec)
+{
+    void *ptr;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!elems)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    ptr = vector_emplace_at_n(pos, count, vec);
+    CATCHZ(vec);
+    
+    memcpy(ptr, elems, count*vec->esize);
+    
+    RET(ptr, vec);
+}
+
+void* vector_emplace_at(int pos, struct vector *vec)
+{
+    return vector_emplace_at_n(pos, 1, vec);
+}
+
+// opens a gap of count uninitialized slots in front of pos
+void* vector_emplace_at_n(int pos, int count, struct vector *vec)
+{
+    void *ptr;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(count <= 0)
+        RETZ(ALG_ERROR_BAD_SIZE, vec);
+    
     if(pos < 0 || pos >= vec->size)
         RETZ(ALG_ERROR_INDEX_RANGE, vec);
     
-    vector_autogrow(vec);
+    vector_autogrow_n(count, vec);
     CATCHZ(vec);
     
     ptr = vec->mem+pos*vec->esize;
-    memmove(ptr+vec->esize, ptr, (vec->size-pos)*vec->esize);
-    vec->pos += vec->esize;
-    vec->size++;
-    memcpy(ptr, elem, vec->esize);
+    memmove(ptr+count*vec->esize, ptr, (vec->size-pos)*vec->esize);
+    ALG_STAT(vec, moved, (vec->size-pos)*vec->esize);
+    vec->pos += count*vec->esize;
+    vec->size += count;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
     
     RET(ptr, vec);
 }
@@ -270,6 +992,9 @@ void vector_rem_custom(int pos, void *dst, alg_mapfun fun, struct vector *vec)
     if(!vec)
         RETV(ALG_ERROR_BAD_STRUCTURE, vec);
     
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
     if(pos < 0 || pos >= vec->size)
         RETV(ALG_ERROR_INDEX_RANGE, vec);
     
@@ -282,8 +1007,10 @@ void vector_rem_custom(int pos, void *dst, alg_mapfun fun, struct vector *vec)
         RETV(ret, vec);
     
     memmove(ptr, ptr+vec->esize, (vec->size-pos-1)*vec->esize);
+    ALG_STAT(vec, moved, (vec->size-pos-1)*vec->esize);
     vec->pos -= vec->esize;
     vec->size--;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
     
     vector_autoshrink(vec);
     CATCHV(vec);
@@ -291,12 +1018,12 @@ void vector_rem_custom(int pos, void *dst, alg_mapfun fun, struct vector *vec)
     vec->error = ALG_SUCCESS;
 }
 
-void vector_clear(struct vector *vec)
+void vector_del_range(int pos, int count, struct vector *vec)
 {
-    vector_clear_custom(0, 0, vec);
+    vector_del_range_custom(pos, count, 0, vec);
 }
 
-void vector_clear_custom(alg_foldfun fun, void *state, struct vector *vec)
+void vector_del_range_custom(int pos, int count, alg_mapfun fun, struct vector *vec)
 {
     int i, ret;
     void *ptr;
@@ -304,13 +1031,27 @@ void vector_clear_custom(alg_foldfun fun, void *state, struct vector *vec)
     if(!vec)
         RETV(ALG_ERROR_BAD_STRUCTURE, vec);
     
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(count <= 0)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    if(pos < 0 || pos+count > vec->size)
+        RETV(ALG_ERROR_INDEX_RANGE, vec);
+    
+    ptr = vec->mem+pos*vec->esize;
+    
     if(fun)
-        for(i=0, ptr=vec->mem; i<vec->size; i++, ptr += vec->esize)
-            if((ret = fun(i, state, ptr)) != ALG_SUCCESS)
+        for(i=0; i<count; i++)
+            if((ret = fun(ptr+i*vec->esize)) != ALG_SUCCESS)
                 RETV(ret, vec);
     
-    vec->pos = vec->mem;
-    vec->size = 0;
+    memmove(ptr, ptr+count*vec->esize, (vec->size-pos-count)*vec->esize);
+    ALG_STAT(vec, moved, (vec->size-pos-count)*vec->esize);
+    vec->pos -= count*vec->esize;
+    vec->size -= count;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
     
     vector_autoshrink(vec);
     CATCHV(vec);
@@ -318,140 +1059,1880 @@ void vector_clear_custom(alg_foldfun fun, void *state, struct vector *vec)
     vec->error = ALG_SUCCESS;
 }
 
-void vector_set_capacity(int capacity, struct vector *vec)
+void vector_clear(struct vector *vec)
 {
-    vector_set_capacity_custom(capacity, 0, 0, vec);
+    vector_clear_custom(0, 0, vec);
 }
 
-void vector_set_capacity_custom(int capacity, alg_foldfun fun, void *state, struct vector *vec)
+void vector_clear_custom(alg_foldfun fun, void *state, struct vector *vec)
 {
-    int i, count, ret;
+    int i, ret;
     void *ptr;
     
     if(!vec)
         RETV(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    if(capacity <= 0)
-        RETV(ALG_ERROR_BAD_SIZE, vec);
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    if(capacity < vec->capacity)
-    {
-        if(capacity < vec->size)
-        {
-            vec->pos = vec->mem + capacity*vec->esize;
-            count = vec->size - capacity;
-            vec->size = capacity;
-            
-            if(fun)
-                for(i=capacity, ptr=vec->pos; i<count; i++, ptr += vec->esize)
-                    if((ret = fun(i, state, ptr)) != ALG_SUCCESS)
-                        RETV(ret, vec);
-        }
-        vector_shrink(capacity, vec);
-        CATCHV(vec);
-    }
-    else if(capacity > vec->capacity)
+    if(fun)
+        for(i=0, ptr=vec->mem; i<vec->size; i++, ptr += vec->esize)
+            if((ret = fun(i, state, ptr)) != ALG_SUCCESS)
+                RETV(ret, vec);
+    
+    // only clears that left the vector below the shrink threshold count as idle
+    if(vec->policy.shrink && vec->size <= vec->capacity/vec->policy.shrink)
+        vec->idle++;
+    else
+        vec->idle = 0;
+    
+    vec->pos = vec->mem;
+    vec->size = 0;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    if(vec->idle > vec->policy.decay)
     {
-        vector_grow(capacity, vec);
+        vec->idle = 0;
+        vector_autoshrink(vec);
         CATCHV(vec);
     }
     
-    vec->capacited = capacity;
-    
     vec->error = ALG_SUCCESS;
 }
 
-#ifdef ALG_TEST
-
-#include <stdio.h>
-
-void show_vector(struct vector *vec)
+// kept records move down run by run, so each is moved at most once
+int vector_remove_if(alg_foldfun fun, void *state, struct vector *vec)
 {
-    int i;
-    int *mem = (int*) vec->mem;
+    char *src, *dst, *run, *end;
+    int i, ret = ALG_SUCCESS, removed;
     
-    printf("size: %i | capacity: %i | diff: %i | ", vec->size, vec->capacity, vec->pos-vec->mem);
-    if(vec->size == 0)
-        printf("empty");
-    if(vec->size > 0)
-        printf("%i", mem[0]);
-    if(vec->size > 1)
-        for(i=1; i<vec->size; i++)
-            printf(", %i", mem[i]);
-    printf("\n");
-}
-
-int catch(struct vector *vec)
-{
-    if(vec->error != ALG_SUCCESS)
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!fun)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    end = vec->mem+vec->size*vec->esize;
+    
+    for(i=0, src=dst=run=vec->mem; src<end; i++, src+=vec->esize)
     {
-        printf("error: %s\n", alg_str_error(vec->error));
-        return 1;
+        if((ret = fun(i, src, state)) < 0)
+            break;
+        if(ret > 0)
+        {
+            if(dst != run)
+                memmove(dst, run, src-run);
+            ALG_STAT(vec, moved, (dst != run)*(src-run));
+            dst += src-run;
+            run = src+vec->esize;
+        }
     }
-    return 0;
+    
+    // the rest is kept, also when the predicate failed
+    if(dst != run)
+        memmove(dst, run, end-run);
+    ALG_STAT(vec, moved, (dst != run)*(end-run));
+    dst += end-run;
+    
+    removed = vec->size-(dst-(char*)vec->mem)/vec->esize;
+    vec->size -= removed;
+    vec->pos = dst;
+    
+    if(removed)
+    {
+        vec->status &= ~ALG_STATUS_EYTZINGER;
+        vector_autoshrink(vec);
+        CATCHZ(vec);
+    }
+    
+    // records removed before the predicate failed stay removed and counted
+    if(ret < 0)
+    {
+        vec->error = ret;
+        return removed;
+    }
+    
+    RET(removed, vec);
 }
 
-int main(int argc, char *argv[])
+int vector_remove_if_unstable(alg_foldfun fun, void *state, struct vector *vec)
 {
-    struct vector *vec = 0;
-    int i = 23, j, count;
+    void *ptr;
+    int i = 0, ret = ALG_SUCCESS, removed = 0;
     
-    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
-        return 1;
-    show_vector(vec);
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    vector_push(&i, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    for(i=0; i<ALG_VECTOR_CAPACITY-1; i++)
+    if(!fun)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    while(i < vec->size)
     {
-        vector_push(&i, vec);
-        if(catch(vec))
-            return 1;
+        ptr = vec->mem+i*vec->esize;
+        if((ret = fun(i, ptr, state)) < 0)
+            break;
+        if(!ret)
+        {
+            i++;
+            continue;
+        }
+        
+        vec->pos -= vec->esize;
+        vec->size--;
+        removed++;
+        if(ptr != vec->pos)
+        {
+            memcpy(ptr, vec->pos, vec->esize);
+            ALG_STAT(vec, moved, vec->esize);
+        }
     }
-    show_vector(vec);
     
-    vector_push(&i, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
-    
-    vector_pop(&i, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    if(removed)
+    {
+        vec->status &= ~ALG_STATUS_EYTZINGER;
+        vector_autoshrink(vec);
+        CATCHZ(vec);
+    }
     
-    count = vec->size - vec->capacity/ALG_VECTOR_SHRINK -1;
-    for(i=0; i<count; i++)
+    if(ret < 0)
     {
-        vector_pop(&j, vec);
-        if(catch(vec))
-            return 1;
+        vec->error = ret;
+        return removed;
     }
-    show_vector(vec);
     
-    vector_pop(&i, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    RET(removed, vec);
+}
+
+void* vector_detach(int *size, struct vector *vec)
+{
+    void *mem;
     
-    i = 42;
-    vector_ins(0, &i, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    vector_del(1, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    if(vec->status & ALG_STATUS_MAPPED)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
     
-    vector_set_capacity(23, vec);
-    if(catch(vec))
-        return 1;
-    show_vector(vec);
+    mem = vec->mem;
+    if(size)
+        *size = vec->size;
+    
+    // the next push regrows to the policy capacity
+    vec->mem = 0;
+    vec->pos = 0;
+    vec->size = 0;
+    vec->capacity = 0;
+    vec->idle = 0;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    RET(mem, vec);
+}
+
+void vector_adopt(void *mem, int size, int capacity, struct vector *vec)
+{
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_MAPPED)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!mem)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(size < 0 || capacity < size)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    if(mem != vec->mem)
+        alg_free(vec->mem, vec->alloc);
+    
+    vec->mem = mem;
+    vec->pos = mem+size*vec->esize;
+    vec->size = size;
+    vec->capacity = capacity;
+    vec->idle = 0;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void* vector_find(void *key, int keysize, struct vector *vec)
+{
+    int from = 0, found[ALG_SIMD_WIDTH];
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(!keysize)
+        keysize = vec->esize;
+    
+    if(keysize < 0 || keysize > vec->esize)
+        RETZ(ALG_ERROR_BAD_SIZE, vec);
+    
+    if(!vector_intern_scan(key, keysize, &from, found, 1, vec))
+        RETZ(ALG_ERROR_NOT_FOUND, vec);
+    
+    RET(vec->mem+found[0]*vec->esize, vec);
+}
+
+int vector_find_all(void *key, int keysize, struct vector *dst, struct vector *vec)
+{
+    int from = 0, count, total = 0;
+    int found[ALG_VECTOR_FIND_BATCH+ALG_SIMD_WIDTH];
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(!dst || dst->esize != sizeof(int))
+        RETZ(ALG_ERROR_BAD_DESTINATION, vec);
+    
+    if(!keysize)
+        keysize = vec->esize;
+    
+    if(keysize < 0 || keysize > vec->esize)
+        RETZ(ALG_ERROR_BAD_SIZE, vec);
+    
+    while(from < vec->size)
+    {
+        count = vector_intern_scan(key, keysize, &from, found, ALG_VECTOR_FIND_BATCH, vec);
+        if(!count)
+            continue;
+        
+        vector_push_n(found, count, dst);
+        if(dst->error != ALG_SUCCESS)
+            RETZ(dst->error, vec);
+        total += count;
+    }
+    
+    RET(total, vec);
+}
+
+int vector_count(void *key, int keysize, struct vector *vec)
+{
+    int from = 0;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(!keysize)
+        keysize = vec->esize;
+    
+    if(keysize < 0 || keysize > vec->esize)
+        RETZ(ALG_ERROR_BAD_SIZE, vec);
+    
+    RET(vector_intern_scan(key, keysize, &from, 0, INT_MAX, vec), vec);
+}
+
+int vector_lower_bound(void *key, alg_cmpfun cmp, struct vector *vec)
+{
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key || !cmp)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(vec->status & ALG_STATUS_EYTZINGER)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    RET(vector_intern_bound(key, cmp, 0, vec), vec);
+}
+
+int vector_upper_bound(void *key, alg_cmpfun cmp, struct vector *vec)
+{
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key || !cmp)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(vec->status & ALG_STATUS_EYTZINGER)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    RET(vector_intern_bound(key, cmp, 1, vec), vec);
+}
+
+void* vector_insert_sorted(void *elem, alg_cmpfun cmp, struct vector *vec)
+{
+    int pos;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!elem || !cmp)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(vec->status & ALG_STATUS_EYTZINGER)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    // behind all equal elements, so insertion order is kept among them
+    pos = vector_intern_bound(elem, cmp, 1, vec);
+    
+    if(pos == vec->size)
+        return vector_push(elem, vec);
+    return vector_ins(pos, elem, vec);
+}
+
+void vector_erase_key(void *key, alg_cmpfun cmp, struct vector *vec)
+{
+    int from, to;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key || !cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(vec->status & ALG_STATUS_EYTZINGER)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    from = vector_intern_bound(key, cmp, 0, vec);
+    if(from == vec->size || cmp(vec->mem+from*vec->esize, key))
+        RETV(ALG_ERROR_NOT_FOUND, vec);
+    to = vector_intern_bound(key, cmp, 1, vec);
+    
+    vector_del_range(from, to-from, vec);
+}
+
+void vector_eytzinger(struct vector *vec)
+{
+    char *tmp;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_EYTZINGER)
+        RETV(ALG_SUCCESS, vec);
+    
+    // nothing to move, but the empty layout is a valid one
+    if(!vec->size)
+    {
+        vec->status |= ALG_STATUS_EYTZINGER;
+        RETV(ALG_SUCCESS, vec);
+    }
+    
+    tmp = vector_intern_scratch(vec->size*vec->esize, vec);
+    CATCHV(vec);
+    
+    vector_intern_eytzinger(vec->mem, 0, 1, tmp, vec);
+    memcpy(vec->mem, tmp, vec->size*vec->esize);
+    vec->status |= ALG_STATUS_EYTZINGER;
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void* vector_eytzinger_find(void *key, alg_cmpfun cmp, struct vector *vec)
+{
+    char *mem;
+    int k, esize;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!key || !cmp)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(!(vec->status & ALG_STATUS_EYTZINGER))
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    mem = vec->mem;
+    esize = vec->esize;
+    
+    // descend with the comparison as child offset, the great grandchildren
+    // four levels down share a cache line and are fetched ahead of time
+    for(k=1; k<=vec->size; k=2*k+(cmp(mem+(k-1)*esize, key) < 0))
+        if(16*k <= vec->size)
+            __builtin_prefetch(mem+(16*k-1)*esize);
+    
+    // drop the trailing right turns to get to the lower bound, which only
+    // counts if it is the key itself
+    k >>= __builtin_ffs(~k);
+    if(!k || cmp(mem+(k-1)*esize, key))
+        RETZ(ALG_ERROR_NOT_FOUND, vec);
+    
+    RET(mem+(k-1)*esize, vec);
+}
+
+void vector_sort(alg_cmpfun cmp, struct vector *vec)
+{
+    int depth, n;
+    char *tmp;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    tmp = vector_intern_scratch(vec->esize, vec);
+    CATCHV(vec);
+    
+    for(depth=0, n=vec->size; n; n/=2, depth+=2);
+    vector_intern_qsort(vec->mem, vec->size, depth, vec->esize, cmp, tmp);
+    
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_sort_stable(alg_cmpfun cmp, struct vector *vec)
+{
+    char *tmp;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    tmp = vector_intern_scratch(vec->size*vec->esize, vec);
+    CATCHV(vec);
+    
+    vector_intern_msort(vec->mem, tmp, vec->size, vec->esize, cmp);
+    
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    vec->error = ALG_SUCCESS;
+}
+
+// signed keys get the sign bit of their most significant byte flipped,
+// which puts the negative ones in front
+void vector_intern_radix(int offset, int keysize, int sign, struct vector *vec)
+{
+    int count[256], i, d, sum, n, flip;
+    char *src, *dst, *swap;
+    unsigned char *key;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(offset < 0 || keysize <= 0 || keysize > 8 || offset+keysize > vec->esize)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    dst = vector_intern_scratch(vec->size*vec->esize, vec);
+    CATCHV(vec);
+    src = vec->mem;
+    
+    // one counting pass per key byte, least significant byte first
+    for(d=0; d<keysize; d++)
+    {
+        flip = sign && d == keysize-1 ? 0x80 : 0;
+        memset(count, 0, sizeof(count));
+        key = (unsigned char*)src+offset+d;
+        for(i=0; i<vec->size; i++, key += vec->esize)
+            count[*key^flip]++;
+        
+        key = (unsigned char*)src+offset+d;
+        if(count[*key^flip] == vec->size)
+            continue;
+        
+        for(i=0, sum=0; i<256; i++)
+        {
+            n = count[i];
+            count[i] = sum;
+            sum += n;
+        }
+        for(i=0; i<vec->size; i++, key += vec->esize)
+            memcpy(dst+(count[*key^flip]++)*vec->esize, src+i*vec->esize, vec->esize);
+        
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    
+    if(src != vec->mem)
+        memcpy(vec->mem, src, vec->size*vec->esize);
+    
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_sort_radix(int offset, int keysize, struct vector *vec)
+{
+    vector_intern_radix(offset, keysize, 0, vec);
+}
+
+void vector_sort_radix_signed(int offset, int keysize, struct vector *vec)
+{
+    vector_intern_radix(offset, keysize, 1, vec);
+}
+
+void vector_sort_par(alg_cmpfun cmp, int threads, struct vector *vec)
+{
+    struct vector_par_state par[ALG_THREAD_MAX];
+    struct vector_sort_state s[ALG_THREAD_MAX];
+    int i, count, merges;
+    char *tmp, *swap;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!cmp)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(vec->size < ALG_VECTOR_SORT_PAR)
+    {
+        vector_sort_stable(cmp, vec);
+        return;
+    }
+    
+    tmp = vector_intern_scratch(vec->size*vec->esize, vec);
+    CATCHV(vec);
+    
+    // sort one chunk per thread, then merge neighbouring runs pairwise
+    count = vector_intern_split(alg_thread_count(threads), par, vec);
+    for(i=0; i<count; i++)
+    {
+        s[i].src = vec->mem;
+        s[i].dst = tmp;
+        s[i].cmp = cmp;
+        s[i].esize = vec->esize;
+        s[i].from = par[i].from;
+        s[i].to = par[i].to;
+    }
+    alg_thread_run(count, vector_intern_msort_par, s, sizeof(struct vector_sort_state));
+    
+    while(count > 1)
+    {
+        merges = (count+1)/2;
+        for(i=0; i<merges; i++)
+        {
+            s[i].src = s[0].src;
+            s[i].dst = s[0].dst;
+            s[i].from = s[2*i].from;
+            s[i].mid = s[2*i].to;
+            s[i].to = 2*i+1 < count ? s[2*i+1].to : s[2*i].to;
+        }
+        alg_thread_run(merges, vector_intern_merge_par, s, sizeof(struct vector_sort_state));
+        
+        for(i=0; i<merges; i++)
+        {
+            swap = s[i].src;
+            s[i].src = s[i].dst;
+            s[i].dst = swap;
+        }
+        count = merges;
+    }
+    
+    if(s[0].src != vec->mem)
+        memcpy(vec->mem, s[0].src, vec->size*vec->esize);
+    
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_fold_par(alg_foldfun fun, alg_reducefun reduce, void *state, int statesize, int threads, struct vector *vec)
+{
+    struct vector_par_state *par;
+    void *states;
+    int i, count, ret = ALG_SUCCESS;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!fun || !reduce || !state)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(statesize <= 0)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    threads = vector_intern_threads(threads, vec);
+    
+    par = alg_alloc(threads*(sizeof(struct vector_par_state)+statesize), vec->alloc);
+    if(!par)
+        RETV(ALG_ERROR_NO_MEMORY, vec);
+    states = par+threads;
+    
+    // the first chunk folds into the initial state, the others into zeroed
+    // states, so the initial value is counted once whatever the thread count
+    count = vector_intern_split(threads, par, vec);
+    for(i=0; i<count; i++)
+    {
+        par[i].fold = fun;
+        par[i].state = i ? states+i*statesize : state;
+        if(i)
+            memset(par[i].state, 0, statesize);
+    }
+    
+    alg_thread_run(count, vector_intern_fold, par, sizeof(struct vector_par_state));
+    
+    for(i=0; i<count && ret == ALG_SUCCESS; i++)
+        ret = par[i].ret;
+    
+    // reduce in chunk order, so the reducer only has to be associative
+    for(i=1; i<count && ret == ALG_SUCCESS; i++)
+        ret = reduce(state, par[i].state);
+    
+    alg_free(par, vec->alloc);
+    ALG_STAT(vec, allocs, 1);
+    ALG_STAT(vec, frees, 1);
+    
+    if(ret != ALG_SUCCESS)
+        RETV(ret, vec);
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_map_par(alg_mapfun fun, int threads, struct vector *vec)
+{
+    struct vector_par_state *par;
+    int i, count, ret = ALG_SUCCESS;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!fun)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    threads = vector_intern_threads(threads, vec);
+    
+    par = alg_alloc(threads*sizeof(struct vector_par_state), vec->alloc);
+    if(!par)
+        RETV(ALG_ERROR_NO_MEMORY, vec);
+    
+    count = vector_intern_split(threads, par, vec);
+    for(i=0; i<count; i++)
+        par[i].map = fun;
+    
+    alg_thread_run(count, vector_intern_map, par, sizeof(struct vector_par_state));
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    for(i=0; i<count && ret == ALG_SUCCESS; i++)
+        ret = par[i].ret;
+    
+    alg_free(par, vec->alloc);
+    ALG_STAT(vec, allocs, 1);
+    ALG_STAT(vec, frees, 1);
+    
+    if(ret != ALG_SUCCESS)
+        RETV(ret, vec);
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_sync(struct vector *vec)
+{
+    void *base;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!(vec->status & ALG_STATUS_MAPPED) || vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    base = vec->mem-ALG_VECTOR_FILE_HEAD;
+    ((struct alg_io_head*)base)->size = vec->size;
+    
+    if(msync(base, ALG_VECTOR_FILE_HEAD+(size_t)vec->capacity*vec->esize, MS_SYNC))
+        RETV(ALG_ERROR_BAD_DESTINATION, vec);
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_set_capacity(int capacity, struct vector *vec)
+{
+    vector_set_capacity_custom(capacity, 0, 0, vec);
+}
+
+void vector_set_capacity_custom(int capacity, alg_foldfun fun, void *state, struct vector *vec)
+{
+    int i, count, ret;
+    void *ptr;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(capacity <= 0)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    if(capacity < vec->capacity)
+    {
+        if(capacity < vec->size)
+        {
+            vec->pos = vec->mem + capacity*vec->esize;
+            count = vec->size - capacity;
+            vec->size = capacity;
+            vec->status &= ~ALG_STATUS_EYTZINGER;
+            
+            if(fun)
+                for(i=capacity, ptr=vec->pos; i<count; i++, ptr += vec->esize)
+                    if((ret = fun(i, state, ptr)) != ALG_SUCCESS)
+                        RETV(ret, vec);
+        }
+        vector_shrink(capacity, vec);
+        CATCHV(vec);
+    }
+    else if(capacity > vec->capacity)
+    {
+        vector_grow(capacity, vec);
+        CATCHV(vec);
+    }
+    
+    vec->policy.capacity = capacity;
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_set_policy(struct vector_policy *policy, struct vector *vec)
+{
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!policy)
+        RETV(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(policy->grow <= 1 || policy->shrink < 0 || policy->capacity <= 0 || policy->decay < 0)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    vec->policy = *policy;
+    vec->idle = 0;
+    
+    if(vec->capacity < policy->capacity)
+    {
+        vector_grow(policy->capacity, vec);
+        CATCHV(vec);
+    }
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_reserve(int capacity, struct vector *vec)
+{
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(capacity <= 0 || capacity > INT_MAX/vec->esize)
+        RETV(ALG_ERROR_BAD_SIZE, vec);
+    
+    if(capacity > vec->capacity)
+    {
+        vector_grow(capacity, vec);
+        CATCHV(vec);
+    }
+    
+    // autoshrink keeps the reservation, shrink_to_fit gives it back
+    if(capacity > vec->reserved)
+        vec->reserved = capacity;
+    
+    vec->error = ALG_SUCCESS;
+}
+
+void vector_shrink_to_fit(struct vector *vec)
+{
+    int capacity;
+    
+    if(!vec)
+        RETV(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    vec->reserved = 0;
+    capacity = vec->size > vec->policy.capacity ? vec->size : vec->policy.capacity;
+    
+    if(vec->capacity > capacity)
+    {
+        vector_shrink(capacity, vec);
+        CATCHV(vec);
+    }
+    
+    vec->error = ALG_SUCCESS;
+}
+
+int vector_write_fd(int fd, struct vector *vec)
+{
+    char head[ALG_IO_HEAD] __attribute__((aligned(8)));
+    struct iovec iov[2];
+    int ret;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    // header and records leave in one call
+    alg_io_head_init(vec->size, vec->esize, head);
+    iov[0].iov_base = head;
+    iov[0].iov_len = ALG_IO_HEAD;
+    iov[1].iov_base = vec->mem;
+    iov[1].iov_len = (size_t)vec->size*vec->esize;
+    
+    ret = alg_io_writev(fd, iov, 2);
+    RETE(ret, vec);
+}
+
+// replaces the contents by count records read straight into mem
+int vector_intern_read(int fd, int count, struct vector *vec)
+{
+    struct iovec iov;
+    int ret;
+    
+    if(vec->status & ALG_STATUS_RDONLY)
+        RETE(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    // the count comes from the stream, the byte size has to fit an int
+    if(count < 0 || count > INT_MAX/vec->esize)
+        RETE(ALG_ERROR_BAD_SIZE, vec);
+    
+    vec->size = 0;
+    vec->pos = vec->mem;
+    vec->status &= ~ALG_STATUS_EYTZINGER;
+    
+    if(count > vec->capacity)
+    {
+        vector_grow(count, vec);
+        CATCHE(vec);
+    }
+    
+    iov.iov_base = vec->mem;
+    iov.iov_len = (size_t)count*vec->esize;
+    if((ret = alg_io_readv(fd, &iov, 1)) != ALG_SUCCESS)
+        RETE(ret, vec);
+    
+    vec->size = count;
+    vec->pos = vec->mem+count*vec->esize;
+    
+    RETE(ALG_SUCCESS, vec);
+}
+
+int vector_read_fd(int fd, struct vector *vec)
+{
+    long size;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if((size = alg_io_head_read(fd, vec->esize)) < 0)
+        RETE(size, vec);
+    
+    if(size > INT_MAX/vec->esize)
+        RETE(ALG_ERROR_BAD_SIZE, vec);
+    
+    return vector_intern_read(fd, size, vec);
+}
+
+int vector_read_fd_begin(int fd, struct vector_stream *stream, struct vector *vec)
+{
+    long size;
+    
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!stream)
+        RETE(ALG_ERROR_BAD_DESTINATION, vec);
+    
+    if((size = alg_io_head_read(fd, vec->esize)) < 0)
+        RETE(size, vec);
+    
+    stream->fd = fd;
+    stream->left = size;
+    
+    RETE(ALG_SUCCESS, vec);
+}
+
+int vector_read_fd_chunk(int max, struct vector_stream *stream, struct vector *vec)
+{
+    int count;
+    
+    if(!vec)
+        RETZ(ALG_ERROR_BAD_STRUCTURE, vec);
+    
+    if(!stream)
+        RETZ(ALG_ERROR_BAD_SOURCE, vec);
+    
+    if(max <= 0)
+        max = vec->capacity ? vec->capacity : vec->policy.capacity;
+    if(max > INT_MAX/vec->esize)
+        max = INT_MAX/vec->esize;
+    
+    count = stream->left < max ? stream->left : max;
+    if(vector_intern_read(stream->fd, count, vec) != ALG_SUCCESS)
+        return 0;
+    stream->left -= count;
+    
+    RET(count, vec);
+}
+
+int vector_stats(struct alg_stats *dst, struct vector *vec)
+{
+    if(!vec)
+        return ALG_ERROR_BAD_STRUCTURE;
+    
+    if(!dst)
+        RETE(ALG_ERROR_BAD_DESTINATION, vec);
+
+#ifdef ALG_STATS
+    memcpy(dst, &vec->stats, sizeof(struct alg_stats));
+    RETE(ALG_SUCCESS, vec);
+#else
+    RETE(ALG_ERROR_UNSET, vec);
+#endif
+}
+
+#ifdef ALG_TEST
+
+#include "iter.h"
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_PUSH  1000000
+#define BENCH_INS   20000
+
+void show_vector(struct vector *vec)
+{
+    int i;
+    int *mem = (int*) vec->mem;
+    
+    printf("size: %i | capacity: %i | diff: %i | ", vec->size, vec->capacity, vec->pos-vec->mem);
+    if(vec->size == 0)
+        printf("empty");
+    if(vec->size > 0)
+        printf("%i", mem[0]);
+    if(vec->size > 1)
+        for(i=1; i<vec->size; i++)
+            printf(", %i", mem[i]);
+    printf("\n");
+}
+
+int catch(struct vector *vec)
+{
+    if(vec->error != ALG_SUCCESS)
+    {
+        printf("error: %s\n", alg_str_error(vec->error));
+        return 1;
+    }
+    return 0;
+}
+
+double bench_ms(clock_t start)
+{
+    return (clock()-start)*1000.0/CLOCKS_PER_SEC;
+}
+
+int test_policy()
+{
+    struct vector *vec = 0;
+    struct vector_policy policy = {1.5, 4, 4, 2};
+    int i, data[100];
+    
+    for(i=0; i<100; i++)
+        data[i] = i;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    vector_set_policy(&policy, vec);
+    if(catch(vec))
+        return 1;
+    
+    for(i=0; i<20; i++)
+        vector_push(&i, vec);
+    printf("grow 1.5: ");
+    show_vector(vec);
+    
+    vector_push_n(data, 100, vec);
+    for(i=0; i<4; i++)
+    {
+        vector_clear(vec);
+        vector_push_n(data, 10, vec);
+        if(catch(vec))
+            return 1;
+        printf("idle clear %i: capacity %i\n", i+1, vec->capacity);
+    }
+    
+    vector_shrink_to_fit(vec);
+    if(catch(vec))
+        return 1;
+    printf("shrink to fit: capacity %i\n", vec->capacity);
+    
+    vector_reserve(1000, vec);
+    if(catch(vec))
+        return 1;
+    for(i=0; i<5; i++)
+        vector_pop(0, vec);
+    printf("reserve: capacity %i after pops\n", vec->capacity);
+    if(vec->capacity != 1000)
+        return 1;
+    
+    // an explicit shrink gives the reservation back
+    vector_clear(vec);
+    vector_shrink_to_fit(vec);
+    if(catch(vec) || vec->capacity != policy.capacity)
+        return 1;
+    printf("shrink to fit empty: capacity %i\n", vec->capacity);
+    
+    // counts no capacity can hold are refused before growing
+    vector_emplace_back_n(INT_MAX, vec);
+    if(vec->error != ALG_ERROR_BAD_SIZE)
+        return 1;
+    vector_reserve(INT_MAX, vec);
+    if(vec->error != ALG_ERROR_BAD_SIZE)
+        return 1;
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_sum(int pos, void *elem, void *state)
+{
+    *(long*)state += *(int*)elem;
+    return ALG_SUCCESS;
+}
+
+int test_reduce(void *state, void *other)
+{
+    *(long*)state += *(long*)other;
+    return ALG_SUCCESS;
+}
+
+int test_double(void *elem)
+{
+    *(int*)elem *= 2;
+    return ALG_SUCCESS;
+}
+
+int test_par()
+{
+    struct vector *vec = 0;
+    long sum = 0;
+    int i;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<100000; i++)
+        vector_push(&i, vec);
+    
+    vector_map_par(test_double, 4, vec);
+    if(catch(vec))
+        return 1;
+    
+    vector_fold_par(test_sum, test_reduce, &sum, sizeof(long), 4, vec);
+    if(catch(vec))
+        return 1;
+    printf("parallel sum: %li\n", sum);
+    
+    // a non zero initial state counts once, whatever the thread count
+    for(i=1; i<=8; i++)
+    {
+        sum = 1000;
+        vector_fold_par(test_sum, test_reduce, &sum, sizeof(long), i, vec);
+        if(catch(vec) || sum != 1000+99999L*100000)
+            return 1;
+    }
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+struct test_record
+{
+    int key;
+    char pad[12];
+};
+
+int test_match(int pos, void *elem, void *state)
+{
+    return *(int*)elem == *(int*)state;
+}
+
+int test_find()
+{
+    struct vector *vec = 0, *idx = 0, *rec = 0;
+    struct test_record r = {0};
+    int i, j, key = 7, *found;
+    clock_t start;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    if(vector_init(sizeof(int), &idx) != ALG_SUCCESS)
+        return 1;
+    if(vector_init(sizeof(struct test_record), &rec) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<1000; i++)
+    {
+        j = i%100;
+        vector_push(&j, vec);
+        r.key = j;
+        vector_push(&r, rec);
+    }
+    
+    found = vector_find(&key, 0, vec);
+    if(catch(vec))
+        return 1;
+    printf("find: index %li\n", (long)(found-(int*)vec->mem));
+    
+    printf("count: %i | prefix count: %i\n", vector_count(&key, 0, vec), vector_count(&key, sizeof(int), rec));
+    if(catch(vec) || catch(rec))
+        return 1;
+    
+    vector_find_all(&key, 0, idx, vec);
+    if(catch(vec))
+        return 1;
+    printf("find all: %i matches | last: %i\n", idx->size, ((int*)idx->mem)[idx->size-1]);
+    
+    key = 100;
+    vector_find(&key, 0, vec);
+    if(vec->error != ALG_ERROR_NOT_FOUND)
+        return 1;
+    
+    vector_clear(vec);
+    for(i=0; i<BENCH_PUSH; i++)
+        vector_push(&i, vec);
+    key = BENCH_PUSH-1;
+    
+    start = clock();
+    for(i=0, found=vec->mem; i<vec->size && !test_match(i, found+i, &key); i++);
+    printf("bench: callback scan: %.2f ms\n", bench_ms(start));
+    
+    start = clock();
+    vector_find(&key, 0, vec);
+    printf("bench: vector_find: %.2f ms\n", bench_ms(start));
+    if(catch(vec))
+        return 1;
+    
+    vector_finish(idx);
+    vector_finish(rec);
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_cmp(void *a, void *b)
+{
+    return *(int*)a < *(int*)b ? -1 : *(int*)a > *(int*)b;
+}
+
+int test_sorted(struct vector *vec, int stable)
+{
+    struct test_record *r = vec->mem;
+    int i;
+    
+    // records carry their original position behind the key
+    for(i=1; i<vec->size; i++)
+        if(r[i-1].key > r[i].key || (stable && r[i-1].key == r[i].key
+            && *(int*)r[i-1].pad > *(int*)r[i].pad))
+            return 0;
+    return 1;
+}
+
+int test_sort_fill(int count, struct vector *vec)
+{
+    struct test_record r;
+    int i;
+    
+    vector_clear(vec);
+    srand(count);
+    for(i=0; i<count; i++)
+    {
+        r.key = rand()%1000;
+        memcpy(r.pad, &i, sizeof(int));
+        vector_push(&r, vec);
+    }
+    return catch(vec);
+}
+
+int test_sort()
+{
+    struct vector *vec = 0;
+    struct test_record *r;
+    
+    if(vector_init(sizeof(struct test_record), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    if(test_sort_fill(10000, vec))
+        return 1;
+    vector_sort(test_cmp, vec);
+    if(catch(vec))
+        return 1;
+    printf("sort: %s\n", test_sorted(vec, 0) ? "ok" : "unsorted");
+    
+    if(test_sort_fill(10000, vec))
+        return 1;
+    vector_sort_stable(test_cmp, vec);
+    if(catch(vec))
+        return 1;
+    printf("stable sort: %s\n", test_sorted(vec, 1) ? "ok" : "unsorted");
+    
+    if(test_sort_fill(10000, vec))
+        return 1;
+    vector_sort_radix(0, sizeof(int), vec);
+    if(catch(vec))
+        return 1;
+    printf("radix sort: %s\n", test_sorted(vec, 1) ? "ok" : "unsorted");
+    
+    if(test_sort_fill(10000, vec))
+        return 1;
+    for(r=vec->mem; r<(struct test_record*)vec->pos; r++)
+        r->key -= 500;
+    vector_sort_radix_signed(0, sizeof(int), vec);
+    if(catch(vec))
+        return 1;
+    r = vec->mem;
+    printf("signed radix sort: %s | first %i\n", test_sorted(vec, 1) ? "ok" : "unsorted", r->key);
+    
+    if(test_sort_fill(3*ALG_VECTOR_SORT_PAR, vec))
+        return 1;
+    vector_sort_par(test_cmp, 5, vec);
+    if(catch(vec))
+        return 1;
+    printf("parallel sort: %s\n", test_sorted(vec, 1) ? "ok" : "unsorted");
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_sorted_mode()
+{
+    struct vector *vec = 0;
+    int i, j, lower, upper, *found;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    srand(1);
+    for(i=0; i<1000; i++)
+    {
+        j = rand()%100;
+        vector_insert_sorted(&j, test_cmp, vec);
+        if(catch(vec))
+            return 1;
+    }
+    for(i=1; i<vec->size && ((int*)vec->mem)[i-1] <= ((int*)vec->mem)[i]; i++);
+    printf("insert sorted: %s\n", i == vec->size ? "ok" : "unsorted");
+    
+    j = 50;
+    lower = vector_lower_bound(&j, test_cmp, vec);
+    upper = vector_upper_bound(&j, test_cmp, vec);
+    if(catch(vec))
+        return 1;
+    printf("bounds of 50: %i matches | before: %i\n", upper-lower, ((int*)vec->mem)[lower-1]);
+    
+    vector_erase_key(&j, test_cmp, vec);
+    if(catch(vec))
+        return 1;
+    printf("erase key: %i left\n", vec->size);
+    
+    vector_eytzinger(vec);
+    if(catch(vec))
+        return 1;
+    // 50 was erased, the next larger record is no match
+    vector_eytzinger_find(&j, test_cmp, vec);
+    if(vec->error != ALG_ERROR_NOT_FOUND)
+        return 1;
+    j = 51;
+    found = vector_eytzinger_find(&j, test_cmp, vec);
+    if(catch(vec))
+        return 1;
+    printf("eytzinger find of 51: %i\n", *found);
+    j = 100;
+    vector_eytzinger_find(&j, test_cmp, vec);
+    if(vec->error != ALG_ERROR_NOT_FOUND)
+        return 1;
+    j = 51;
+    vector_eytzinger_find(&j, test_cmp, vec);
+    vector_push(&j, vec);
+    if(catch(vec))
+        return 1;
+    vector_eytzinger_find(&j, test_cmp, vec);
+    if(vec->error != ALG_ERROR_BAD_STRUCTURE)
+        return 1;
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_map()
+{
+    struct vector *vec = 0;
+    char path[] = "/tmp/alg_vector_XXXXXX";
+    long sum = 0, head;
+    int i, fd;
+    
+    if((fd = mkstemp(path)) < 0)
+        return 1;
+    close(fd);
+    
+    if(vector_map_file(path, sizeof(int), 0, &vec) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<1000; i++)
+        vector_push(&i, vec);
+    if(catch(vec))
+        return 1;
+    vector_sync(vec);
+    if(catch(vec))
+        return 1;
+    if(vector_finish(vec) != ALG_SUCCESS)
+        return 1;
+    
+    vec = 0;
+    if(vector_map_file(path, sizeof(int), ALG_VECTOR_MAP_RDONLY|ALG_VECTOR_MAP_POPULATE, &vec) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<vec->size; i++)
+        sum += ((int*)vec->mem)[i];
+    printf("mapped: size %i | sum %li\n", vec->size, sum);
+    vector_push(&i, vec);
+    if(vec->error != ALG_ERROR_BAD_STRUCTURE)
+        return 1;
+    vector_del(0, vec);
+    if(vec->error != ALG_ERROR_BAD_STRUCTURE)
+        return 1;
+    vector_sort(test_cmp, vec);
+    if(vec->error != ALG_ERROR_BAD_STRUCTURE)
+        return 1;
+    if(vector_finish(vec) != ALG_SUCCESS)
+        return 1;
+    
+    vec = 0;
+    if(vector_map_file(path, sizeof(long), 0, &vec) != ALG_ERROR_BAD_SIZE)
+        return 1;
+    
+    // a negative record count in the header is refused
+    head = -1;
+    if((fd = open(path, O_WRONLY)) < 0 || pwrite(fd, &head, sizeof(long), 8) != sizeof(long))
+        return 1;
+    close(fd);
+    vec = 0;
+    if(vector_map_file(path, sizeof(int), ALG_VECTOR_MAP_RDONLY, &vec) != ALG_ERROR_BAD_SIZE)
+        return 1;
+    printf("mapped: read only refused mutation and bad header\n");
+    
+    unlink(path);
+    return 0;
+}
+
+int test_allocs;
+
+void* test_alloc(size_t size, void *ctx)
+{
+    test_allocs++;
+    return malloc(size);
+}
+
+void* test_realloc(void *ptr, size_t size, void *ctx)
+{
+    return realloc(ptr, size);
+}
+
+void test_free(void *ptr, void *ctx)
+{
+    test_allocs--;
+    free(ptr);
+}
+
+int test_allocator()
+{
+    struct alg_allocator alloc = {test_alloc, test_realloc, test_free, 0};
+    struct vector *vec = 0;
+    int i;
+    
+    if(vector_init_alloc(sizeof(int), &alloc, &vec) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<100; i++)
+        vector_push(&i, vec);
+    if(catch(vec))
+        return 1;
+    printf("live allocations: %i\n", test_allocs);
+    
+    if(vector_finish(vec) != ALG_SUCCESS)
+        return 1;
+    printf("live allocations after finish: %i\n", test_allocs);
+    
+    return 0;
+}
+
+int test_stats()
+{
+    struct vector *vec = 0;
+    struct alg_stats stats;
+    int i;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<100; i++)
+        vector_push(&i, vec);
+    vector_ins(0, &i, vec);
+    while(vec->size > 1)
+        vector_del(0, vec);
+    
+    if(vector_stats(&stats, vec) == ALG_ERROR_UNSET)
+        printf("stats: %s\n", alg_str_error(vec->error));
+    else
+        printf("stats: grows %lu | shrinks %lu | copied %lu | moved %lu | allocs %lu\n",
+            stats.grows, stats.shrinks, stats.copied, stats.moved, stats.allocs);
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_unchecked()
+{
+    struct vector *vec = 0;
+    long sum = 0, usum = 0;
+    int i, *data;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        vector_push(&i, vec);
+    
+    for(i=0; i<vector_size(vec); i++)
+        sum += *(int*)vector_at(i, vec);
+    for(i=0; i<vector_size_unchecked(vec); i++)
+        usum += *(int*)vector_at_unchecked(i, vec);
+    for(i=0, data=vector_data(vec); i<vec->size; i++)
+        usum += data[i];
+    
+    printf("unchecked: sum %li | twice unchecked %li\n", sum, usum);
+    
+    return vector_finish(vec) != ALG_SUCCESS || 2*sum != usum;
+}
+
+ALG_VECTOR_DEFINE(int, ivec)
+
+int test_typed()
+{
+    struct vector *vec = 0;
+    long sum = 0;
+    int i;
+    
+    if(ivec_init(&vec) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<100; i++)
+        ivec_push(i, vec);
+    ivec_set(0, 100, vec);
+    for(i=0; i<ivec_size(vec); i++)
+        sum += ivec_get(i, vec);
+    printf("typed: size %i | capacity %i | sum %li | ", ivec_size(vec), vec->capacity, sum);
+    
+    for(sum=0; ivec_size(vec) > 1;)
+        sum += ivec_pop(vec);
+    printf("popped %li | capacity %i\n", sum, vec->capacity);
+    
+    ivec_ins(0, 7, vec);
+    ivec_ins(1, 8, vec);
+    i = ivec_rem(0, vec);
+    ivec_del(ivec_find(100, vec)-ivec_data(vec), vec);
+    if(catch(vec) || i != 7 || ivec_size(vec) != 1 || ivec_get(0, vec) != 8 || ivec_find(100, vec))
+        return 1;
+    ivec_clear(vec);
+    
+    return ivec_finish(vec) != ALG_SUCCESS;
+}
+
+int test_emplace()
+{
+    struct vector *vec = 0;
+    int i, *ptr;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    *(int*)vector_emplace_back(vec) = 1;
+    ptr = vector_emplace_back_n(4, vec);
+    for(i=0; i<4; i++)
+        ptr[i] = 10+i;
+    *(int*)vector_emplace_at(0, vec) = 0;
+    ptr = vector_emplace_at_n(2, 2, vec);
+    ptr[0] = 5;
+    ptr[1] = 6;
+    if(catch(vec))
+        return 1;
+    
+    printf("emplace:");
+    for(i=0; i<vec->size; i++)
+        printf(" %i", ((int*)vec->mem)[i]);
+    printf("\n");
+    
+    vector_emplace_at(vec->size, vec);
+    catch(vec);
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_odd(int pos, void *elem, void *state)
+{
+    return *(int*)elem % 2;
+}
+
+int test_odd_below(int pos, void *elem, void *state)
+{
+    if(*(int*)elem == *(int*)state)
+        return ALG_ERROR_BAD_SOURCE;
+    return *(int*)elem % 2;
+}
+
+int test_remove_if()
+{
+    struct vector *vec = 0;
+    int i, removed;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        vector_push(&i, vec);
+    
+    removed = vector_remove_if(test_odd, 0, vec);
+    if(catch(vec))
+        return 1;
+    printf("remove_if: %i | size %i/%i | [0..4]:", removed, vec->size, vec->capacity);
+    for(i=0; i<5; i++)
+        printf(" %i", ((int*)vec->mem)[i]);
+    printf(" | last %i\n", ((int*)vec->mem)[vec->size-1]);
+    
+    vector_clear(vec);
+    for(i=0; i<10; i++)
+        vector_push(&i, vec);
+    
+    removed = vector_remove_if_unstable(test_odd, 0, vec);
+    if(catch(vec))
+        return 1;
+    printf("remove_if_unstable: %i |", removed);
+    for(i=0; i<vec->size; i++)
+        printf(" %i", ((int*)vec->mem)[i]);
+    printf("\n");
+    
+    // a failing predicate still reports what went before it
+    vector_clear(vec);
+    for(i=0; i<10; i++)
+        vector_push(&i, vec);
+    i = 6;
+    removed = vector_remove_if(test_odd_below, &i, vec);
+    if(vec->error != ALG_ERROR_BAD_SOURCE || removed != 3 || vec->size != 7)
+        return 1;
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int iter_square(void *elem)
+{
+    *(int*)elem *= *(int*)elem;
+    return ALG_SUCCESS;
+}
+
+int iter_sum(int pos, void *elem, void *state)
+{
+    *(long*)state += *(int*)elem;
+    return 0;
+}
+
+int iter_third_n(void **elems, int count, char *keep, void *state)
+{
+    int i;
+    for(i=0; i<count; i++)
+        keep[i] = *(int*)elems[i] % 3 == 0;
+    return 0;
+}
+
+int iter_add_n(void **elems, int count, void *state)
+{
+    int i;
+    for(i=0; i<count; i++)
+        *(int*)elems[i] += *(int*)state;
+    return 0;
+}
+
+int iter_sum_n(void **elems, int count, void *state)
+{
+    int i;
+    for(i=0; i<count; i++)
+        *(long*)state += *(int*)elems[i];
+    return 0;
+}
+
+int test_iter()
+{
+    struct vector *vec = 0;
+    struct alg_iter it;
+    long sum = 0;
+    int i, count, add = 1000;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<1000; i++)
+        vector_push(&i, vec);
+    
+    alg_iter_vector(vec, &it);
+    alg_iter_filter(test_odd, 0, &it);
+    alg_iter_map(iter_square, &it);
+    alg_iter_take(5, &it);
+    count = alg_iter_fold(iter_sum, &sum, &it);
+    printf("iter: %i folded | sum %li | source %i\n", count, sum, ((int*)vec->mem)[3]);
+    
+    sum = 0;
+    alg_iter_vector(vec, &it);
+    alg_iter_filter_n(iter_third_n, 0, &it);
+    alg_iter_map_n(iter_add_n, &add, &it);
+    alg_iter_filter(test_odd, 0, &it);
+    alg_iter_take(100, &it);
+    count = alg_iter_fold_n(iter_sum_n, &sum, &it);
+    printf("iter batched: %i folded | sum %li\n", count, sum);
+    
+    // both modes have to agree
+    sum = 0;
+    count = alg_iter_fold(iter_sum, &sum, &it);
+    printf("iter single: %i folded | sum %li\n", count, sum);
+    
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int test_fd()
+{
+    struct vector *vec = 0, *chunk = 0;
+    struct vector_stream stream;
+    char path[] = "/tmp/alg_vector_XXXXXX";
+    long sum = 0;
+    int i, fd, count;
+    
+    if((fd = mkstemp(path)) < 0)
+        return 1;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS
+        || vector_init(sizeof(int), &chunk) != ALG_SUCCESS)
+        return 1;
+    for(i=0; i<1000; i++)
+        vector_push(&i, vec);
+    
+    if(vector_write_fd(fd, vec) != ALG_SUCCESS)
+        return 1;
+    
+    lseek(fd, 0, SEEK_SET);
+    vector_clear(vec);
+    if(vector_read_fd(fd, vec) != ALG_SUCCESS)
+        return 1;
+    printf("fd: %i read | last %i\n", vec->size, ((int*)vec->mem)[vec->size-1]);
+    
+    lseek(fd, 0, SEEK_SET);
+    if(vector_read_fd_begin(fd, &stream, chunk) != ALG_SUCCESS)
+        return 1;
+    printf("fd chunks:");
+    while((count = vector_read_fd_chunk(300, &stream, chunk)) > 0)
+    {
+        for(i=0; i<count; i++)
+            sum += ((int*)chunk->mem)[i];
+        printf(" %i", count);
+    }
+    if(catch(chunk))
+        return 1;
+    printf(" | sum %li\n", sum);
+    close(fd);
+    vector_finish(vec);
+    
+    // the written file maps as it is
+    vec = 0;
+    if(vector_map_file(path, sizeof(int), ALG_VECTOR_MAP_RDONLY, &vec) != ALG_SUCCESS)
+        return 1;
+    printf("fd mapped: %i\n", vec->size);
+    vector_finish(vec);
+    
+    vec = 0;
+    vector_init(sizeof(long), &vec);
+    fd = open(path, O_RDONLY);
+    vector_read_fd(fd, vec);
+    catch(vec);
+    close(fd);
+    unlink(path);
+    
+    return vector_finish(vec) != ALG_SUCCESS || vector_finish(chunk) != ALG_SUCCESS;
+}
+
+int test_adopt()
+{
+    struct vector *a = 0, *b = 0;
+    int i, size, *mem;
+    
+    if(vector_init(sizeof(int), &a) != ALG_SUCCESS
+        || vector_init(sizeof(int), &b) != ALG_SUCCESS)
+        return 1;
+    
+    for(i=0; i<100; i++)
+        vector_push(&i, a);
+    
+    mem = vector_detach(&size, a);
+    if(catch(a))
+        return 1;
+    printf("detached: %i | left: %i/%i\n", size, a->size, a->capacity);
+    
+    vector_adopt(mem, size, size, b);
+    if(catch(b))
+        return 1;
+    printf("adopted: %i | same buffer: %s | b[99]: %i\n", b->size,
+        b->mem == mem ? "yes" : "no", *(int*)vector_at(99, b));
+    
+    vector_push(&i, a);
+    if(catch(a))
+        return 1;
+    printf("regrown: %i/%i\n", a->size, a->capacity);
+    
+    vector_adopt(0, 0, 0, a);
+    catch(a);
+    
+    return vector_finish(a) != ALG_SUCCESS || vector_finish(b) != ALG_SUCCESS;
+}
+
+int bench_bulk()
+{
+    struct vector *vec = 0;
+    int i, *data;
+    clock_t start;
+    
+    data = malloc(BENCH_PUSH*sizeof(int));
+    if(!data)
+        return 1;
+    for(i=0; i<BENCH_PUSH; i++)
+        data[i] = i;
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    
+    start = clock();
+    for(i=0; i<BENCH_PUSH; i++)
+        vector_push(&data[i], vec);
+    printf("bench: %i x vector_push: %.2f ms\n", BENCH_PUSH, bench_ms(start));
+    vector_clear(vec);
+    
+    start = clock();
+    vector_push_n(data, BENCH_PUSH, vec);
+    printf("bench: vector_push_n(%i): %.2f ms\n", BENCH_PUSH, bench_ms(start));
+    if(catch(vec))
+        return 1;
+    
+    vector_set_capacity(1, vec);
+    vector_push_n(data, 1, vec);
+    start = clock();
+    for(i=0; i<BENCH_INS; i++)
+        vector_ins(0, &data[i], vec);
+    printf("bench: %i x vector_ins(0): %.2f ms\n", BENCH_INS, bench_ms(start));
+    
+    vector_set_capacity(1, vec);
+    vector_push_n(data, 1, vec);
+    start = clock();
+    vector_ins_n(0, data, BENCH_INS, vec);
+    printf("bench: vector_ins_n(0, %i): %.2f ms\n", BENCH_INS, bench_ms(start));
+    if(catch(vec))
+        return 1;
+    
+    start = clock();
+    for(i=0; i<BENCH_INS; i++)
+        vector_del(0, vec);
+    printf("bench: %i x vector_del(0): %.2f ms\n", BENCH_INS, bench_ms(start));
+    
+    vector_ins_n(0, data, BENCH_INS, vec);
+    start = clock();
+    vector_del_range(0, BENCH_INS, vec);
+    printf("bench: vector_del_range(0, %i): %.2f ms\n", BENCH_INS, bench_ms(start));
+    if(catch(vec))
+        return 1;
+    
+    free(data);
+    return vector_finish(vec) != ALG_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    struct vector *vec = 0;
+    int i = 23, j, count;
+    int data[] = {7, 8, 9};
+    
+    if(vector_init(sizeof(int), &vec) != ALG_SUCCESS)
+        return 1;
+    show_vector(vec);
+    
+    vector_push(&i, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    for(i=0; i<ALG_VECTOR_CAPACITY-1; i++)
+    {
+        vector_push(&i, vec);
+        if(catch(vec))
+            return 1;
+    }
+    show_vector(vec);
+    
+    vector_push(&i, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_pop(&i, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    count = vec->size - vec->capacity/ALG_VECTOR_SHRINK -1;
+    for(i=0; i<count; i++)
+    {
+        vector_pop(&j, vec);
+        if(catch(vec))
+            return 1;
+    }
+    show_vector(vec);
+    
+    vector_pop(&i, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    i = 42;
+    vector_ins(0, &i, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_del(1, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_push_n(data, 3, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_ins_n(1, data, 3, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_del_range(1, 3, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_del_range(vec->size-3, 3, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
+    
+    vector_set_capacity(23, vec);
+    if(catch(vec))
+        return 1;
+    show_vector(vec);
     
     vector_set_capacity(3, vec);
     if(catch(vec))
@@ -466,7 +2947,12 @@ int main(int argc, char *argv[])
     if(vector_finish(vec) != ALG_SUCCESS)
         return 1;
     
-    return 0;
+    if(test_policy() || test_par() || test_find() || test_sort() || test_sorted_mode() || test_map() || test_allocator()
+        || test_stats() || test_unchecked() || test_typed() || test_emplace()
+        || test_adopt() || test_remove_if() || test_iter() || test_fd())
+        return 1;
+    
+    return bench_bulk();
 }
 
 #endif
@@ -24,19 +24,57 @@
 #define __ALG_VECTOR_H__
 
 #include "fun.h"
+#include "alloc.h"
+#include "stats.h"
+#include "error.h"
+#include "status.h"
 
 #define ALG_VECTOR_CAPACITY 10
 #define ALG_VECTOR_GROW     2   // factor to grow or shrink
 #define ALG_VECTOR_SHRINK   3   // shrink threshold (capacity/size)
+#define ALG_VECTOR_DECAY    0   // idle clears before shrinking
+#define ALG_VECTOR_PAR_MIN  4096    // size below which parallel calls stay single threaded
+#define ALG_VECTOR_FIND_BATCH 256   // indices collected per push by vector_find_all
+#define ALG_VECTOR_SORT_SMALL 16    // runs left to insertion sort
+#define ALG_VECTOR_SORT_PAR 65536   // size below which vector_sort_par stays single threaded
+
+#define ALG_VECTOR_MAP_RDONLY     1   // read only shared mapping, mutators refuse it
+#define ALG_VECTOR_MAP_CREATE     2   // create the file if missing
+#define ALG_VECTOR_MAP_POPULATE   4   // prefault the whole mapping
+#define ALG_VECTOR_MAP_RANDOM     8   // access pattern hints
+#define ALG_VECTOR_MAP_SEQUENTIAL 16
+
+#define ALG_VECTOR_FILE_HEAD 64       // bytes in front of the records
+
+// position in a record stream that is read chunk by chunk
+struct vector_stream
+{
+    long left;  // records not read yet
+    int fd;
+};
+
+struct vector_policy
+{
+    double grow;    // factor to grow or shrink, greater than 1
+    int shrink;     // shrink threshold (capacity/size), 0 to never shrink
+    int capacity;   // minimum capacity
+    int decay;      // idle clears before shrinking
+};
 
 struct vector
 {
-    void *mem, *pos;
-    int size, esize, capacity, error, capacited;
+    void *mem, *pos, *scratch;
+    struct alg_allocator *alloc;
+    struct vector_policy policy;
+    int size, esize, capacity, error, idle, scratched, fd;
+    int reserved;   // capacity autoshrink keeps until shrink_to_fit
     char status;
+    struct alg_stats stats;
 };
 
 int vector_init(int elemsize, struct vector **vec);
+int vector_init_alloc(int elemsize, struct alg_allocator *alloc, struct vector **vec);
+int vector_map_file(const char *path, int elemsize, int flags, struct vector **vec);
 int vector_finish(struct vector *vec);
 int vector_finish_custom(alg_foldfun fun, void *state, struct vector *vec);
 
@@ -47,18 +85,215 @@ int   vector_capacity(struct vector *vec);
 
 void* vector_push(void *elem, struct vector *vec);
 void* vector_ins(int pos, void *elem, struct vector *vec);
+void* vector_push_n(void *elems, int count, struct vector *vec);
+void* vector_ins_n(int pos, void *elems, int count, struct vector *vec);
+
+// the emplace functions hand out uninitialized slots to be filled in place
+void* vector_emplace_back(struct vector *vec);
+void* vector_emplace_back_n(int count, struct vector *vec);
+void* vector_emplace_at(int pos, struct vector *vec);
+void* vector_emplace_at_n(int pos, int count, struct vector *vec);
 
 void vector_pop(void *dst, struct vector *vec);
 void vector_pop_custom(void *dst, alg_mapfun fun, struct vector *vec);
 void vector_del(int pos, struct vector *vec);
 void vector_del_custom(int pos, alg_mapfun fun, struct vector *vec);
+void vector_del_range(int pos, int count, struct vector *vec);
+void vector_del_range_custom(int pos, int count, alg_mapfun fun, struct vector *vec);
 void vector_rem(int pos, void *dst, struct vector *vec);
 void vector_rem_custom(int pos, void *dst, alg_mapfun fun, struct vector *vec);
 void vector_clear(struct vector *vec);
 void vector_clear_custom(alg_foldfun fun, void *state, struct vector *vec);
 
+// Ownership of the buffer changes hands without copying. A detached buffer
+// is released by the caller with the vector's allocator, an adopted one has
+// to come from that allocator. Mapped vectors refuse both.
+void* vector_detach(int *size, struct vector *vec);
+void  vector_adopt(void *mem, int size, int capacity, struct vector *vec);
+
+// Drop every record the predicate returns a positive value for in a single
+// pass and return how many went. A negative value stops with that error in
+// vec->error, the records removed before it are still counted.
+// The unstable variant fills gaps with the last record and asks about the
+// moved record at the same position again.
+int   vector_remove_if(alg_foldfun fun, void *state, struct vector *vec);
+int   vector_remove_if_unstable(alg_foldfun fun, void *state, struct vector *vec);
+
+void* vector_find(void *key, int keysize, struct vector *vec);
+int   vector_find_all(void *key, int keysize, struct vector *dst, struct vector *vec);
+int   vector_count(void *key, int keysize, struct vector *vec);
+
+int   vector_lower_bound(void *key, alg_cmpfun cmp, struct vector *vec);
+int   vector_upper_bound(void *key, alg_cmpfun cmp, struct vector *vec);
+void* vector_insert_sorted(void *elem, alg_cmpfun cmp, struct vector *vec);
+void  vector_erase_key(void *key, alg_cmpfun cmp, struct vector *vec);
+// eytzinger lays a sorted vector out as a breadth first tree, find then
+// returns the first record comparing equal to key or fails with NOT_FOUND,
+// any mutation drops the layout
+void  vector_eytzinger(struct vector *vec);
+void* vector_eytzinger_find(void *key, alg_cmpfun cmp, struct vector *vec);
+
+void vector_sort(alg_cmpfun cmp, struct vector *vec);
+void vector_sort_stable(alg_cmpfun cmp, struct vector *vec);
+// radix sorts take keysize bytes at offset as a little endian integer, the
+// plain one as unsigned, the signed one in two's complement
+void vector_sort_radix(int offset, int keysize, struct vector *vec);
+void vector_sort_radix_signed(int offset, int keysize, struct vector *vec);
+void vector_sort_par(alg_cmpfun cmp, int threads, struct vector *vec);
+
+// fold_par folds the first chunk into state and every other chunk into a
+// zeroed state, which has to be the identity of reduce, the chunk results
+// are then reduced into state in order
+void vector_fold_par(alg_foldfun fun, alg_reducefun reduce, void *state, int statesize, int threads, struct vector *vec);
+void vector_map_par(alg_mapfun fun, int threads, struct vector *vec);
+
+void vector_sync(struct vector *vec);
+
 void vector_set_capacity(int capacity, struct vector *vec);
 void vector_set_capacity_custom(int capacity, alg_foldfun fun, void *state, struct vector *vec);
+void vector_set_policy(struct vector_policy *policy, struct vector *vec);
+// a reservation outlasts autoshrink until shrink_to_fit gives it back,
+// which never goes below the policy capacity
+void vector_reserve(int capacity, struct vector *vec);
+void vector_shrink_to_fit(struct vector *vec);
+
+// Records are written behind a small header in one writev, the output is a
+// valid vector_map_file file. Reading replaces the contents and fills mem
+// directly, the chunked reader holds at most max records (0 for the current
+// capacity) at a time and returns how many it read, 0 at the end.
+int vector_write_fd(int fd, struct vector *vec);
+int vector_read_fd(int fd, struct vector *vec);
+int vector_read_fd_begin(int fd, struct vector_stream *stream, struct vector *vec);
+int vector_read_fd_chunk(int max, struct vector_stream *stream, struct vector *vec);
+
+int vector_stats(struct alg_stats *dst, struct vector *vec);
+
+// Inline accessors without any checks and without touching the error field,
+// the vector and the index have to be valid.
+
+static inline void* vector_data(struct vector *vec)
+{
+    return vec->mem;
+}
+
+static inline void* vector_at_unchecked(int pos, struct vector *vec)
+{
+    return vec->mem+pos*vec->esize;
+}
+
+static inline int vector_size_unchecked(struct vector *vec)
+{
+    return vec->size;
+}
+
+// Typed wrappers over a struct vector of T, ALG_VECTOR_DEFINE(int, ivec)
+// emits ivec_init, ivec_push and so on. Elements are assigned instead of
+// copied with a runtime size and push and pop only call into the library
+// when the capacity has to change or the vector is mapped read only. at,
+// get, set, pop and rem do no checks, find compares the bytes of elem.
+// Functions taking callbacks or keys of other types have no typed wrapper,
+// they are called on the vector directly.
+
+#define ALG_VECTOR_DEFINE(T, name) \
+static inline int name##_init(struct vector **vec) \
+{ \
+    return vector_init(sizeof(T), vec); \
+} \
+static inline int name##_finish(struct vector *vec) \
+{ \
+    return vector_finish(vec); \
+} \
+static inline int name##_size(struct vector *vec) \
+{ \
+    return vec->size; \
+} \
+static inline T* name##_data(struct vector *vec) \
+{ \
+    return (T*)vec->mem; \
+} \
+static inline T* name##_at(int pos, struct vector *vec) \
+{ \
+    return (T*)vec->mem+pos; \
+} \
+static inline T name##_get(int pos, struct vector *vec) \
+{ \
+    return ((T*)vec->mem)[pos]; \
+} \
+static inline void name##_set(int pos, T elem, struct vector *vec) \
+{ \
+    ((T*)vec->mem)[pos] = elem; \
+} \
+static inline T* name##_push(T elem, struct vector *vec) \
+{ \
+    T *ptr = (T*)vec->pos; \
+    if(vec->size == vec->capacity || vec->status & ALG_STATUS_RDONLY) \
+    { \
+        if(!(ptr = (T*)vector_emplace_back(vec))) \
+            return 0; \
+        *ptr = elem; \
+        return ptr; \
+    } \
+    *ptr = elem; \
+    vec->pos = ptr+1; \
+    vec->size++; \
+    vec->status &= ~ALG_STATUS_EYTZINGER; \
+    vec->error = ALG_SUCCESS; \
+    return ptr; \
+} \
+static inline T name##_pop(struct vector *vec) \
+{ \
+    T elem = ((T*)vec->pos)[-1]; \
+    if(vec->policy.shrink && vec->size-1 <= vec->capacity/vec->policy.shrink \
+        && vec->capacity > vec->policy.capacity) \
+        vector_pop(0, vec); \
+    else if(vec->status & ALG_STATUS_RDONLY) \
+        vector_pop(0, vec); \
+    else \
+    { \
+        vec->pos = (T*)vec->pos-1; \
+        vec->size--; \
+        vec->status &= ~ALG_STATUS_EYTZINGER; \
+        vec->error = ALG_SUCCESS; \
+    } \
+    return elem; \
+} \
+static inline T* name##_push_n(const T *elems, int count, struct vector *vec) \
+{ \
+    return (T*)vector_push_n((void*)elems, count, vec); \
+} \
+static inline T* name##_ins(int pos, T elem, struct vector *vec) \
+{ \
+    T *ptr = (T*)vector_emplace_at(pos, vec); \
+    if(ptr) \
+        *ptr = elem; \
+    return ptr; \
+} \
+static inline T* name##_ins_n(int pos, const T *elems, int count, struct vector *vec) \
+{ \
+    return (T*)vector_ins_n(pos, (void*)elems, count, vec); \
+} \
+static inline void name##_del(int pos, struct vector *vec) \
+{ \
+    vector_del(pos, vec); \
+} \
+static inline void name##_del_range(int pos, int count, struct vector *vec) \
+{ \
+    vector_del_range(pos, count, vec); \
+} \
+static inline T name##_rem(int pos, struct vector *vec) \
+{ \
+    T elem = ((T*)vec->mem)[pos]; \
+    vector_del(pos, vec); \
+    return elem; \
+} \
+static inline T* name##_find(T elem, struct vector *vec) \
+{ \
+    return (T*)vector_find(&elem, sizeof(T), vec); \
+} \
+static inline void name##_clear(struct vector *vec) \
+{ \
+    vector_clear(vec); \
+}
 
 #endif
 
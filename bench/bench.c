@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define BENCH_ESIZES    4
+#define BENCH_MAX_SIZE  100000000L
+#define BENCH_MEMORY    1024        // MiB per case
+
+struct bench_result
+{
+    long ops;
+    double ns;
+    long rss;
+};
+
+int esizes[BENCH_ESIZES] = {4, 16, 64, 256};
+
+double bench_now()
+{
+    struct timespec ts;
+    
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec*1e9+ts.tv_nsec;
+}
+
+// bulk cases repeat a pass over size elements for stable timings
+long bench_rounds(long size)
+{
+    return size < BENCH_ROUND_OPS ? BENCH_ROUND_OPS/size : 1;
+}
+
+// linear cases are bounded by the total number of element visits
+long bench_linear(long size)
+{
+    long ops = BENCH_WORK/size;
+    
+    if(ops < BENCH_LINEAR_MIN)
+        return BENCH_LINEAR_MIN;
+    if(ops > BENCH_LINEAR_MAX)
+        return BENCH_LINEAR_MAX;
+    return ops;
+}
+
+// elements carry an int key in front, the rest is filler
+void bench_elem(void *elem, int esize, int key)
+{
+    memset(elem, key, esize);
+    memcpy(elem, &key, sizeof(int));
+}
+
+// every case runs in its own process, so the peak RSS belongs to it alone
+// and a container too large for the machine only takes down the child
+int bench_run(struct bench_case *c, int esize, long size, struct bench_result *res)
+{
+    struct rusage usage;
+    int fd[2], status;
+    pid_t pid;
+    
+    if(pipe(fd))
+        return 1;
+    
+    if(!(pid = fork()))
+    {
+        close(fd[0]);
+        srand(size);
+        res->ns = 0;
+        res->ops = c->run(esize, size, &res->ns);
+        getrusage(RUSAGE_SELF, &usage);
+        res->rss = usage.ru_maxrss;
+        _exit(write(fd[1], res, sizeof(struct bench_result)) != sizeof(struct bench_result));
+    }
+    
+    close(fd[1]);
+    status = pid < 0 || read(fd[0], res, sizeof(struct bench_result)) != sizeof(struct bench_result);
+    close(fd[0]);
+    if(pid > 0)
+        waitpid(pid, 0, 0);
+    
+    return status || res->ops <= 0;
+}
+
+void usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-f csv|json] [-n max size] [-m memory MiB] [case...]\n", name);
+    exit(1);
+}
+
+int selected(const char *name, int argc, char *argv[])
+{
+    int i;
+    
+    if(optind == argc)
+        return 1;
+    for(i=optind; i<argc; i++)
+        if(!strcmp(argv[i], name))
+            return 1;
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_case *groups[] = {bench_vector, bench_list}, *c;
+    struct bench_result res;
+    long size, max = BENCH_MAX_SIZE, memory = BENCH_MEMORY;
+    int g, e, opt, json = 0, first = 1;
+    double nsop;
+    
+    while((opt = getopt(argc, argv, "f:n:m:")) != -1)
+        switch(opt)
+        {
+            case 'f':
+                if(!strcmp(optarg, "json"))
+                    json = 1;
+                else if(strcmp(optarg, "csv"))
+                    usage(argv[0]);
+                break;
+            case 'n':
+                max = atof(optarg);
+                break;
+            case 'm':
+                memory = atol(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    
+    if(json)
+        printf("[\n");
+    else
+        printf("case,esize,size,ops,ns_op,ops_s,peak_rss_kb\n");
+    
+    for(g=0; g<sizeof(groups)/sizeof(groups[0]); g++)
+        for(c=groups[g]; c->name; c++)
+        {
+            if(!selected(c->name, argc, argv))
+                continue;
+            
+            for(e=0; e<BENCH_ESIZES; e++)
+                for(size=10; size<=max; size*=10)
+                {
+                    // doubled for the slack a growing container keeps
+                    if(size*(2*esizes[e]+c->footprint) > memory << 20)
+                        break;
+                    
+                    if(bench_run(c, esizes[e], size, &res))
+                    {
+                        fprintf(stderr, "%s/%i/%li: failed\n", c->name, esizes[e], size);
+                        continue;
+                    }
+                    
+                    nsop = res.ns/res.ops;
+                    if(json)
+                        printf("%s  {\"case\": \"%s\", \"esize\": %i, \"size\": %li, \"ops\": %li, "
+                            "\"ns_op\": %.3f, \"ops_s\": %.0f, \"peak_rss_kb\": %li}",
+                            first ? "" : ",\n", c->name, esizes[e], size, res.ops, nsop, 1e9/nsop, res.rss);
+                    else
+                        printf("%s,%i,%li,%li,%.3f,%.0f,%li\n",
+                            c->name, esizes[e], size, res.ops, nsop, 1e9/nsop, res.rss);
+                    fflush(stdout);
+                    first = 0;
+                }
+        }
+    
+    if(json)
+        printf("\n]\n");
+    
+    return 0;
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#ifndef __ALG_BENCH_H__
+#define __ALG_BENCH_H__
+
+#define BENCH_ROUND_OPS 1000000     // bulk cases repeat until this many ops
+#define BENCH_WORK      100000000   // element visits for linear cases
+#define BENCH_LINEAR_MIN 10         // ops of linear cases at least
+#define BENCH_LINEAR_MAX 100000     // and at most
+
+// A case runs ops operations on a container of size elements of esize
+// bytes and adds the time spent in them to *ns. Setup and teardown are not
+// timed. The footprint is the bookkeeping per element, used to skip cases
+// above the memory limit.
+
+typedef long bench_fun(int esize, long size, double *ns);
+
+struct bench_case
+{
+    const char *name;
+    bench_fun *run;
+    int footprint;
+};
+
+extern struct bench_case bench_vector[];
+extern struct bench_case bench_list[];
+
+double bench_now();
+long bench_rounds(long size);
+long bench_linear(long size);
+void bench_elem(void *elem, int esize, int key);
+
+#endif
@@ -0,0 +1,172 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "alg/list.h"
+#include <stdlib.h>
+
+#define ELEM(name) char name[esize]; bench_elem(name, esize, 0)
+
+struct list* bench_list_fill(int esize, long size)
+{
+    struct list *l = 0;
+    long i;
+    ELEM(elem);
+    
+    if(list_init(esize, &l))
+        return 0;
+    
+    for(i=0; i<size; i++)
+    {
+        bench_elem(elem, esize, i);
+        list_push(elem, l);
+    }
+    
+    return l;
+}
+
+int bench_list_key(int pos, void *elem, void *state)
+{
+    return *(int*)elem == *(int*)state;
+}
+
+int bench_list_sum(int pos, void *elem, void *state)
+{
+    *(long*)state += *(int*)elem;
+    return 0;
+}
+
+long bench_list_push(int esize, long size, double *ns)
+{
+    struct list *l = 0;
+    long i, r, rounds = bench_rounds(size);
+    double start;
+    ELEM(elem);
+    
+    if(list_init(esize, &l))
+        return 0;
+    
+    for(r=0; r<rounds; r++)
+    {
+        list_clear(l);
+        start = bench_now();
+        for(i=0; i<size; i++)
+            list_push(elem, l);
+        *ns += bench_now()-start;
+    }
+    
+    list_finish(l);
+    return rounds*size;
+}
+
+long bench_list_at(int esize, long size, double *ns)
+{
+    struct list *l = bench_list_fill(esize, size);
+    long i, ops = bench_linear(size);
+    double start;
+    
+    if(!l)
+        return 0;
+    
+    start = bench_now();
+    for(i=0; i<ops; i++)
+        list_at(rand()%size, l);
+    *ns += bench_now()-start;
+    
+    list_finish(l);
+    return ops;
+}
+
+long bench_list_find(int esize, long size, double *ns)
+{
+    struct list *l = bench_list_fill(esize, size);
+    long i, ops = bench_linear(size);
+    double start;
+    int key;
+    
+    if(!l)
+        return 0;
+    
+    start = bench_now();
+    for(i=0; i<ops; i++)
+    {
+        key = rand()%size;
+        list_find(bench_list_key, &key, l);
+    }
+    *ns += bench_now()-start;
+    
+    list_finish(l);
+    return ops;
+}
+
+// counts visited elements as ops
+long bench_list_fold(int esize, long size, double *ns)
+{
+    struct list *l = bench_list_fill(esize, size);
+    long r, rounds = bench_rounds(size), sum = 0;
+    double start;
+    
+    if(!l)
+        return 0;
+    
+    start = bench_now();
+    for(r=0; r<rounds; r++)
+        list_fold(bench_list_sum, &sum, l);
+    *ns += bench_now()-start;
+    
+    list_finish(l);
+    return rounds*size;
+}
+
+// counts cleared elements as ops
+long bench_list_clear(int esize, long size, double *ns)
+{
+    struct list *l = 0;
+    long i, r, rounds = bench_rounds(size);
+    double start;
+    ELEM(elem);
+    
+    if(list_init(esize, &l))
+        return 0;
+    
+    for(r=0; r<rounds; r++)
+    {
+        for(i=0; i<size; i++)
+            list_push(elem, l);
+        start = bench_now();
+        list_clear(l);
+        *ns += bench_now()-start;
+    }
+    
+    list_finish(l);
+    return rounds*size;
+}
+
+struct bench_case bench_list[] =
+{
+    {"list_push", bench_list_push, sizeof(struct list_elem)},
+    {"list_at", bench_list_at, sizeof(struct list_elem)},
+    {"list_find", bench_list_find, sizeof(struct list_elem)},
+    {"list_fold", bench_list_fold, sizeof(struct list_elem)},
+    {"list_clear", bench_list_clear, sizeof(struct list_elem)},
+    {0, 0, 0}
+};
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2012 Martin Rödel aka Yomin
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy 
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+ * copies of the Software, and to permit persons to whom the Software is 
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in 
+ * all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN 
+ * THE SOFTWARE.
+ */
+
+#include "bench.h"
+#include "alg/vector.h"
+#include <stdlib.h>
+
+#define ELEM(name) char name[esize]; bench_elem(name, esize, 0)
+
+long bench_vector_push(int esize, long size, double *ns)
+{
+    struct vector *vec = 0;
+    long i, r, rounds = bench_rounds(size);
+    double start;
+    ELEM(elem);
+    
+    if(vector_init(esize, &vec))
+        return 0;
+    
+    for(r=0; r<rounds; r++)
+    {
+        vector_clear(vec);
+        vector_shrink_to_fit(vec);
+        start = bench_now();
+        for(i=0; i<size; i++)
+            vector_push(elem, vec);
+        *ns += bench_now()-start;
+    }
+    
+    vector_finish(vec);
+    return rounds*size;
+}
+
+// inserts at random positions, a batch of size inserts is taken back
+// untimed so the vector stays between size and twice that
+long bench_vector_ins(int esize, long size, double *ns)
+{
+    struct vector *vec = 0;
+    long i, ops = bench_linear(size), done = 0;
+    double start;
+    ELEM(elem);
+    
+    if(vector_init(esize, &vec))
+        return 0;
+    
+    for(i=0; i<size; i++)
+        vector_push(elem, vec);
+    
+    while(done < ops)
+    {
+        start = bench_now();
+        for(i=0; i<size && done < ops; i++, done++)
+            vector_ins(rand()%(size+i), elem, vec);
+        *ns += bench_now()-start;
+        vector_del_range(size, vector_size(vec)-size, vec);
+    }
+    
+    vector_finish(vec);
+    return ops;
+}
+
+// pops everything with the default policy, so the vector shrinks on the way
+long bench_vector_pop(int esize, long size, double *ns)
+{
+    struct vector *vec = 0;
+    long i, r, rounds = bench_rounds(size);
+    double start;
+    ELEM(elem);
+    
+    if(vector_init(esize, &vec))
+        return 0;
+    
+    for(r=0; r<rounds; r++)
+    {
+        for(i=0; i<size; i++)
+            vector_push(elem, vec);
+        start = bench_now();
+        for(i=0; i<size; i++)
+            vector_pop(0, vec);
+        *ns += bench_now()-start;
+    }
+    
+    vector_finish(vec);
+    return rounds*size;
+}
+
+struct bench_case bench_vector[] =
+{
+    {"vector_push", bench_vector_push, 0},
+    {"vector_ins", bench_vector_ins, 0},
+    {"vector_pop", bench_vector_pop, 0},
+    {0, 0, 0}
+};